@@ -1,5 +1,6 @@
 #include <array>
 #include <bitset>
+#include <chrono>
 #include <cstddef>
 #include <map>
 #include <optional>
@@ -53,6 +54,49 @@ namespace {
         return diagonal_matrix;
     }
 
+#ifdef NPC_STATS
+    struct stats_counters {
+        array<unsigned long long, cxx::NPC_STATS_ENTRIES> calls{};
+        array<unsigned long long, cxx::NPC_STATS_ENTRIES> nanoseconds{};
+        unsigned long long closure_row_updates = 0;
+    };
+
+    stats_counters &get_stats() {
+        static stats_counters stats;
+        return stats;
+    }
+
+    // Counts a call of the entry point and measures its duration.
+    class stats_scope {
+    public:
+        explicit stats_scope(const cxx::npc_stats_entry entry)
+            : entry_(entry), start_(std::chrono::steady_clock::now()) {}
+
+        ~stats_scope() {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            stats_counters &stats = get_stats();
+
+            stats.calls[entry_]++;
+            stats.nanoseconds[entry_] +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count();
+        }
+
+        stats_scope(const stats_scope &) = delete;
+        stats_scope &operator=(const stats_scope &) = delete;
+
+    private:
+        const cxx::npc_stats_entry entry_;
+        const std::chrono::steady_clock::time_point start_;
+    };
+
+    #define NPC_STATS_SCOPE(entry) const stats_scope npc_stats_scope_(entry)
+    #define NPC_STATS_CLOSURE_ROW_UPDATE() get_stats().closure_row_updates++
+#else
+    #define NPC_STATS_SCOPE(entry) ((void) 0)
+    #define NPC_STATS_CLOSURE_ROW_UPDATE() ((void) 0)
+#endif
+
     bool is_valid_name(const string &name) {
         static const regex re("^[a-zA-Z0-9_]+$");
         return regex_match(name, re);
@@ -91,6 +135,8 @@ namespace {
 
 namespace cxx {
     long npc_new_collection(void) {
+        NPC_STATS_SCOPE(NPC_STATS_NEW_COLLECTION);
+
         static long new_id = 0;
 
         if (new_id >= 0) {
@@ -102,6 +148,8 @@ namespace cxx {
     }
 
     void npc_delete_collection(long id) {
+        NPC_STATS_SCOPE(NPC_STATS_DELETE_COLLECTION);
+
         const auto opt_it = find_collection(id);
 
         if (opt_it.has_value()) {
@@ -110,6 +158,8 @@ namespace cxx {
     }
 
     bool npc_new_poset(long id, char const *name) {
+        NPC_STATS_SCOPE(NPC_STATS_NEW_POSET);
+
         if (!name || !is_valid_name(name)) {
             return false;
         }
@@ -129,6 +179,8 @@ namespace cxx {
     }
 
     void npc_delete_poset(long id, char const *name) {
+        NPC_STATS_SCOPE(NPC_STATS_DELETE_POSET);
+
         if (name) {
             const auto opt_it = find_collection(id);
 
@@ -139,6 +191,8 @@ namespace cxx {
     }
 
     bool npc_copy_poset(long id, char const *name_dst, char const *name_src) {
+        NPC_STATS_SCOPE(NPC_STATS_COPY_POSET);
+
         if (!name_dst || !name_src || !is_valid_name(name_dst)) {
             return false;
         }
@@ -154,6 +208,8 @@ namespace cxx {
     }
 
     char const *npc_first_poset(long id) {
+        NPC_STATS_SCOPE(NPC_STATS_FIRST_POSET);
+
         const auto opt_it = find_collection(id);
 
         if (!opt_it.has_value() || (*opt_it)->second.empty()) {
@@ -164,6 +220,8 @@ namespace cxx {
     }
 
     char const *npc_next_poset(long id, char const *name) {
+        NPC_STATS_SCOPE(NPC_STATS_NEXT_POSET);
+
         if (!name) {
             return nullptr;
         }
@@ -178,6 +236,8 @@ namespace cxx {
     }
 
     bool npc_add_relation(long id, char const *name, size_t x, size_t y) {
+        NPC_STATS_SCOPE(NPC_STATS_ADD_RELATION);
+
         if (!name || max(x, y) >= SIZE) {
             return false;
         }
@@ -198,6 +258,7 @@ namespace cxx {
         for (size_t z = 0; z < SIZE; z++) {
             if (matrix[z].test(x)) {
                 matrix[z] |= matrix[y];
+                NPC_STATS_CLOSURE_ROW_UPDATE();
             }
         }
 
@@ -205,6 +266,8 @@ namespace cxx {
     }
 
     bool npc_is_relation(long id, char const *name, size_t x, size_t y) {
+        NPC_STATS_SCOPE(NPC_STATS_IS_RELATION);
+
         if (!name || max(x, y) >= SIZE) {
             return false;
         }
@@ -215,6 +278,8 @@ namespace cxx {
     }
 
     bool npc_remove_relation(long id, char const *name, size_t x, size_t y) {
+        NPC_STATS_SCOPE(NPC_STATS_REMOVE_RELATION);
+
         if (!name || x == y || max(x, y) >= SIZE) {
             return false;
         }
@@ -244,14 +309,20 @@ namespace cxx {
     }
 
     size_t npc_size() {
+        NPC_STATS_SCOPE(NPC_STATS_SIZE);
+
         return get_collections().size();
     }
 
     size_t npc_poset_size() {
+        NPC_STATS_SCOPE(NPC_STATS_POSET_SIZE);
+
         return SIZE;
     }
 
     size_t npc_collection_size(long id) {
+        NPC_STATS_SCOPE(NPC_STATS_COLLECTION_SIZE);
+
         const auto opt_it = find_collection(id);
 
         if (opt_it.has_value()) {
@@ -260,4 +331,27 @@ namespace cxx {
 
         return 0;
     }
+
+#ifdef NPC_STATS
+    void npc_stats(struct npc_stats *stats) {
+        if (!stats) {
+            return;
+        }
+
+        const stats_counters &counters = get_stats();
+
+        for (size_t i = 0; i < NPC_STATS_ENTRIES; i++) {
+            stats->calls[i] = counters.calls[i];
+            stats->nanoseconds[i] = counters.nanoseconds[i];
+        }
+
+        stats->closure_row_updates = counters.closure_row_updates;
+        stats->collections = get_collections().size();
+        stats->posets = 0;
+
+        for (const auto &[id, posets] : get_collections()) {
+            stats->posets += posets.size();
+        }
+    }
+#endif
 } /* namespace cxx */
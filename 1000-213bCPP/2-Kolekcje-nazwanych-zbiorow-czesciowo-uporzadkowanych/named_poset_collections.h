@@ -125,6 +125,52 @@ size_t npc_poset_size(void);
  */
 size_t npc_collection_size(long id);
 
+#ifdef NPC_STATS
+
+/**
+ * Punkty wejścia modułu, dla których zbierane są statystyki. Wartość
+ * <code>NPC_STATS_ENTRIES</code> jest liczbą punktów wejścia.
+ */
+enum npc_stats_entry {
+    NPC_STATS_NEW_COLLECTION,
+    NPC_STATS_DELETE_COLLECTION,
+    NPC_STATS_NEW_POSET,
+    NPC_STATS_DELETE_POSET,
+    NPC_STATS_COPY_POSET,
+    NPC_STATS_FIRST_POSET,
+    NPC_STATS_NEXT_POSET,
+    NPC_STATS_ADD_RELATION,
+    NPC_STATS_IS_RELATION,
+    NPC_STATS_REMOVE_RELATION,
+    NPC_STATS_SIZE,
+    NPC_STATS_POSET_SIZE,
+    NPC_STATS_COLLECTION_SIZE,
+    NPC_STATS_ENTRIES
+};
+
+/**
+ * Statystyki modułu: liczba wywołań i łączny czas (w nanosekundach) każdego
+ * punktu wejścia, liczba wierszy macierzy relacji zmodyfikowanych podczas
+ * domykania przechodniego oraz aktualne liczby kolekcji i zbiorów częściowo
+ * uporządkowanych.
+ */
+struct npc_stats {
+    unsigned long long calls[NPC_STATS_ENTRIES];
+    unsigned long long nanoseconds[NPC_STATS_ENTRIES];
+    unsigned long long closure_row_updates;
+    size_t collections;
+    size_t posets;
+};
+
+/**
+ * Jeśli <code>stats</code> nie jest <code>NULL</code>, zapisuje w nim aktualne
+ * statystyki modułu. Funkcja jest dostępna tylko wtedy, gdy moduł został
+ * skompilowany z makrem <code>NPC_STATS</code>.
+ */
+void npc_stats(struct npc_stats *stats);
+
+#endif /* NPC_STATS */
+
 #ifdef __cplusplus
         } /* extern "C" */
     } /* namespace cxx */
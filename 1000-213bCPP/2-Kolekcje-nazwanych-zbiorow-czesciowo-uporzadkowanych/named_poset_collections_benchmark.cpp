@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "named_poset_collections.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr std::size_t DEFAULT_OPS = 1'000'000;
+    constexpr std::size_t MIN_OPS = 100;
+    // Collections whose relation matrices would exceed this limit are skipped.
+    constexpr std::size_t MEMORY_LIMIT = 64 << 20;
+    constexpr std::size_t COLLECTION_SIZES[] = {1, 16, 128};
+
+    struct relation {
+        const std::string *name;
+        std::size_t x;
+        std::size_t y;
+    };
+
+    struct workload {
+        long id;
+        std::vector<std::string> names;
+        std::mt19937_64 rng;
+        // Relations added by the "add" phase, removed by the "remove" phase.
+        std::vector<relation> added = {};
+
+        std::size_t element() {
+            return std::uniform_int_distribution<std::size_t>(
+                0, cxx::npc_poset_size() - 1)(rng);
+        }
+
+        const std::string &name() {
+            return names[std::uniform_int_distribution<std::size_t>(
+                0, names.size() - 1)(rng)];
+        }
+    };
+
+    // Returns the peak resident set size of the process in KiB.
+    long peak_rss_kib() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    void print_row(const std::size_t posets, const char *op,
+                   const std::size_t ops, const double seconds) {
+        const std::size_t n = cxx::npc_poset_size();
+        const double matrix_mib =
+            static_cast<double>(posets * n * n / 8) / (1 << 20);
+
+        std::cout << std::setw(6) << n << std::setw(8) << posets
+                  << std::setw(10) << op << std::setw(10) << ops
+                  << std::setw(16) << std::fixed << std::setprecision(0);
+
+        // An empty or unmeasurably short phase has no meaningful rate.
+        if (ops > 0 && seconds > 0) {
+            std::cout << ops / seconds;
+        } else {
+            std::cout << "-";
+        }
+
+        std::cout << std::setw(14) << std::setprecision(2) << matrix_mib
+                  << std::setw(14) << peak_rss_kib() << '\n';
+    }
+
+    // Runs op() `ops` times and reports the throughput.
+    void measure(workload &w, const char *op_name, const std::size_t ops,
+                 const std::function<void(workload &)> &op) {
+        const auto start = clock_type::now();
+
+        for (std::size_t i = 0; i < ops; i++) {
+            op(w);
+        }
+
+        const std::chrono::duration<double> elapsed = clock_type::now() - start;
+        print_row(w.names.size(), op_name, ops, elapsed.count());
+    }
+
+    void run(const std::size_t posets, const std::size_t base_ops) {
+        const std::size_t n = cxx::npc_poset_size();
+
+        // Mutations cost up to O(N^2 / word size), so they are scaled down to
+        // keep every configuration within a comparable time budget.
+        const std::size_t scale = (n / 32) * (n / 32);
+        const std::size_t mutating_ops = std::max(base_ops / scale, MIN_OPS);
+
+        workload w{cxx::npc_new_collection(), {}, std::mt19937_64(n + posets)};
+
+        for (std::size_t i = 0; i < posets; i++) {
+            w.names.push_back("p" + std::to_string(i));
+            cxx::npc_new_poset(w.id, w.names.back().c_str());
+        }
+
+        measure(w, "add", mutating_ops, [](workload &w) {
+            const relation r = {&w.name(), w.element(), w.element()};
+
+            if (cxx::npc_add_relation(w.id, r.name->c_str(), r.x, r.y)) {
+                w.added.push_back(r);
+            }
+        });
+        measure(w, "is", base_ops, [](workload &w) {
+            cxx::npc_is_relation(w.id, w.name().c_str(), w.element(),
+                                 w.element());
+        });
+        // Random pairs are almost never related, so the relations added above
+        // are removed instead, latest first, to measure actual removals.
+        measure(w, "remove", w.added.size(), [](workload &w) {
+            const relation r = w.added.back();
+            w.added.pop_back();
+            cxx::npc_remove_relation(w.id, r.name->c_str(), r.x, r.y);
+        });
+        measure(w, "copy", mutating_ops, [](workload &w) {
+            const std::string &src = w.name();
+            cxx::npc_copy_poset(w.id, w.name().c_str(), src.c_str());
+        });
+
+        cxx::npc_delete_collection(w.id);
+    }
+} /* namespace */
+
+int main(int argc, char *argv[]) {
+    const std::size_t n = cxx::npc_poset_size();
+    const std::size_t base_ops =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_OPS;
+
+    std::cout << std::setw(6) << "N" << std::setw(8) << "posets"
+              << std::setw(10) << "op" << std::setw(10) << "ops"
+              << std::setw(16) << "ops/s" << std::setw(14) << "matrix MiB"
+              << std::setw(14) << "peak RSS KiB" << '\n';
+
+    for (const std::size_t posets : COLLECTION_SIZES) {
+        if (posets * n * n / 8 <= MEMORY_LIMIT) {
+            run(posets, base_ops);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#include "named_poset_collections.h"
+
+#ifdef NDEBUG
+  #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+
+int main() {
+  struct npc_stats stats;
+  long id = npc_new_collection();
+  assert(npc_new_poset(id, "a"));
+  assert(npc_new_poset(id, "b"));
+  assert(npc_copy_poset(id, "c", "a"));
+  assert(npc_add_relation(id, "a", 0, 1));
+  assert(npc_add_relation(id, "a", 1, 2));
+  assert(!npc_add_relation(id, "a", 2, 0));
+  assert(npc_is_relation(id, "a", 0, 2));
+
+  npc_stats(&stats);
+  assert(stats.calls[NPC_STATS_NEW_COLLECTION] == 1);
+  assert(stats.calls[NPC_STATS_NEW_POSET] == 2);
+  assert(stats.calls[NPC_STATS_COPY_POSET] == 1);
+  assert(stats.calls[NPC_STATS_ADD_RELATION] == 3);
+  assert(stats.calls[NPC_STATS_IS_RELATION] == 1);
+  assert(stats.calls[NPC_STATS_REMOVE_RELATION] == 0);
+  assert(stats.closure_row_updates == 3);
+  assert(stats.collections == 1);
+  assert(stats.posets == 3);
+
+  npc_delete_collection(id);
+  npc_stats(&stats);
+  assert(stats.calls[NPC_STATS_DELETE_COLLECTION] == 1);
+  assert(stats.collections == 0);
+  assert(stats.posets == 0);
+  npc_stats(NULL);
+}
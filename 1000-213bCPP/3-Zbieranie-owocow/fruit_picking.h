@@ -2,38 +2,51 @@
 #define FRUIT_PICKING_H
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
-#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
-#include <set>
+#include <ranges>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
-using std::advance;
+using std::array;
 using std::derived_from;
 using std::forward;
 using std::get;
 using std::initializer_list;
 using std::is_const_v;
-using std::list;
-using std::make_move_iterator;
 using std::min;
 using std::move;
-using std::multiset;
+using std::nullopt;
+using std::optional;
 using std::ostream;
-using std::prev;
 using std::remove_cvref_t;
 using std::remove_reference_t;
+using std::shared_ptr;
 using std::size_t;
 using std::string;
 using std::string_view;
+using std::ranges::subrange;
 using std::tuple;
+using std::uint64_t;
+using std::uint8_t;
 using std::unordered_map;
+using std::vector;
 using std::weak_ordering;
 
 enum class Taste { SWEET, SOUR };
@@ -42,64 +55,68 @@ enum class Quality { HEALTHY, ROTTEN, WORMY };
 
 namespace hidden {
     using fruit_tuple_t = tuple<Taste, Size, Quality>;
+
+    // Printed names of the fruit attributes, indexed by their values.
+    constexpr inline array<string_view, 2> TASTE_NAMES{"słodki", "kwaśny"};
+    constexpr inline array<string_view, 3> SIZE_NAMES{"duży", "średni", "mały"};
+    constexpr inline array<string_view, 3> QUALITY_NAMES{
+        "zdrowy", "nadgniły", "robaczywy"};
+
+    /// Returns the printed names of a fruit's taste, size and quality.
+    constexpr array<string_view, 3> fruit_names(const Taste& t, const Size& s,
+                                                const Quality& q) noexcept {
+        return {TASTE_NAMES[std::to_underlying(t)],
+                SIZE_NAMES[std::to_underlying(s)],
+                QUALITY_NAMES[std::to_underlying(q)]};
+    }
 }
 
 class Fruit {
     private:
-        Taste taste_;
-        Size size_;
-        Quality quality_;
-
-        /// Returns a string representation of the fruit's taste.
-        constexpr string taste_str() const {
-            switch (taste_) {
-                case Taste::SWEET: return "słodki";
-                case Taste::SOUR: return "kwaśny";
-            }
-
-            return "";
+        // All three attributes are packed into a single byte:
+        // bit 0 - taste, bits 1-2 - size, bits 3-4 - quality.
+        static constexpr unsigned TASTE_SHIFT = 0;
+        static constexpr unsigned SIZE_SHIFT = 1;
+        static constexpr unsigned QUALITY_SHIFT = 3;
+        static constexpr uint8_t TASTE_MASK = 0b1 << TASTE_SHIFT;
+        static constexpr uint8_t SIZE_MASK = 0b11 << SIZE_SHIFT;
+        static constexpr uint8_t QUALITY_MASK = 0b11 << QUALITY_SHIFT;
+
+        uint8_t bits_;
+
+        static constexpr uint8_t pack(const Taste& t, const Size& s,
+                                      const Quality& q) noexcept {
+            return static_cast<uint8_t>(
+                std::to_underlying(t) << TASTE_SHIFT
+                | std::to_underlying(s) << SIZE_SHIFT
+                | std::to_underlying(q) << QUALITY_SHIFT);
         }
 
-        /// Returns a string representation of the fruit's size.
-        constexpr string size_str() const {
-            switch (size_) {
-                case Size::LARGE: return "duży";
-                case Size::MEDIUM: return "średni";
-                case Size::SMALL: return "mały";
-            }
-
-            return "";
-        }
-
-        /// Returns a string representation of the fruit's quality.
-        constexpr string quality_str() const {
-            switch (quality_) {
-                case Quality::HEALTHY: return "zdrowy";
-                case Quality::ROTTEN: return "nadgniły";
-                case Quality::WORMY: return "robaczywy";
-            }
-
-            return "";
+        constexpr void set_quality(const Quality& q) noexcept {
+            bits_ = static_cast<uint8_t>((bits_ & ~QUALITY_MASK)
+                                         | std::to_underlying(q)
+                                           << QUALITY_SHIFT);
         }
 
     public:
         constexpr Taste taste() const noexcept {
-            return taste_;
+            return static_cast<Taste>((bits_ & TASTE_MASK) >> TASTE_SHIFT);
         }
 
         constexpr Size size() const noexcept {
-            return size_;
+            return static_cast<Size>((bits_ & SIZE_MASK) >> SIZE_SHIFT);
         }
 
         constexpr Quality quality() const noexcept {
-            return quality_;
+            return static_cast<Quality>((bits_ & QUALITY_MASK)
+                                        >> QUALITY_SHIFT);
         }
 
         constexpr Fruit() = delete;
 
         explicit constexpr Fruit(const Taste& t, const Size& s,
                                  const Quality& q)
-            : taste_(t), size_(s), quality_(q) {}
+            : bits_(pack(t, s, q)) {}
 
         constexpr Fruit(const Fruit& fruit) = default;
 
@@ -111,7 +128,7 @@ class Fruit {
 
         /// Converts the fruit into a tuple of (`Taste`, `Size`, `Quality`).
         explicit constexpr operator hidden::fruit_tuple_t() const {
-            return hidden::fruit_tuple_t{taste_, size_, quality_};
+            return hidden::fruit_tuple_t{taste(), size(), quality()};
         }
 
         constexpr Fruit& operator=(const Fruit& fruit) = default;
@@ -120,14 +137,14 @@ class Fruit {
 
         /// Makes a healthy fruit rotten.
         constexpr void go_rotten() {
-            if (quality_ == Quality::HEALTHY)
-                quality_ = Quality::ROTTEN;
+            if (quality() == Quality::HEALTHY)
+                set_quality(Quality::ROTTEN);
         }
 
         /// Infests a healthy fruit with worms.
         constexpr void become_worm_infested() {
-            if (quality_ == Quality::HEALTHY)
-                quality_ = Quality::WORMY;
+            if (quality() == Quality::HEALTHY)
+                set_quality(Quality::WORMY);
         }
 
         constexpr bool operator==(const Fruit& other) const = default;
@@ -135,15 +152,62 @@ class Fruit {
         constexpr auto operator<=>(const Fruit& other) const = delete;
 
         friend ostream& operator<<(ostream& os, const Fruit& fruit) {
-            string repr = "["
-              + fruit.taste_str() + " "
-              + fruit.size_str() + " "
-              + fruit.quality_str() + "]";
-            
-            return os << repr;
+            const auto [taste, size, quality] = hidden::fruit_names(
+                fruit.taste(), fruit.size(), fruit.quality());
+            return os << '[' << taste << ' ' << size << ' ' << quality << ']';
         }
 };
 
+namespace hidden {
+    /**
+     * Formats text into a single reusable buffer and writes it to a stream in
+     * large chunks, instead of one stream operation per token.
+     */
+    class buffered_writer {
+        private:
+            static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+            ostream& os_;
+            string buffer_;
+
+        public:
+            explicit buffered_writer(ostream& os) : os_(os) {}
+
+            buffered_writer(const buffered_writer&) = delete;
+
+            buffered_writer& operator=(const buffered_writer&) = delete;
+
+            buffered_writer& operator<<(const string_view text) {
+                buffer_ += text;
+
+                if (buffer_.size() >= CHUNK_SIZE)
+                    flush();
+
+                return *this;
+            }
+
+            buffered_writer& operator<<(const char c) {
+                return *this << string_view(&c, 1);
+            }
+
+            buffered_writer& operator<<(const Fruit& fruit) {
+                const auto [taste, size, quality] = fruit_names(
+                    fruit.taste(), fruit.size(), fruit.quality());
+                return *this << '[' << taste << ' ' << size << ' ' << quality
+                             << ']';
+            }
+
+            /// Writes the buffered text to the stream.
+            void flush() {
+                os_.write(buffer_.data(),
+                          static_cast<std::streamsize>(buffer_.size()));
+                buffer_.clear();
+            }
+    };
+} /* namespace hidden */
+
+static_assert(sizeof(Fruit) == 1);
+
 constexpr inline Fruit YUMMY_ONE(
     Taste::SWEET,
     Size::LARGE,
@@ -154,29 +218,181 @@ constexpr inline Fruit ROTTY_ONE(
     Size::SMALL,
     Quality::ROTTEN);
 
+class Ranking;
+
 class Picker {
     private:
         string name_;
-        list<Fruit> picked_fruits_;
+        // Fruits are removed only from the front, by advancing
+        // `first_fruit_`; see `pop_first_fruit`. Unlike a deque, a vector
+        // moves without allocating, so moving a picker cannot throw.
+        vector<Fruit> picked_fruits_;
+        size_t first_fruit_ = 0;
+
+        // Worm infestation is applied lazily: every healthy and sweet fruit
+        // among the first `infested_prefix_` stored fruits is in fact wormy.
+        // Use `fruit_at` to read a fruit with its actual quality.
+        size_t infested_prefix_ = 0;
+
+        // Counters indexed by the underlying values of the attributes.
+        array<size_t, 2> cnt_taste_{};
+        array<size_t, 3> cnt_size_{};
+        array<size_t, 3> cnt_quality_{};
+        size_t cnt_healthy_sweet_ = 0;
+
+        // Ranking criteria in order of importance: the numbers of healthy,
+        // sweet, large, medium and small fruits and of all fruits. Kept up to
+        // date by every modification, so comparing pickers is a single
+        // lexicographic comparison.
+        using rank_key_t = array<size_t, 6>;
+        rank_key_t rank_key_{};
+
+        // Polynomial hash of the fruits with their actual qualities: the sum
+        // of fruit_code(i-th fruit) * HASH_BASE^i (mod 2^64). Together with
+        // `name_hash_` it identifies the picker without comparing fruits.
+        static constexpr uint64_t HASH_BASE = 0x100000001b3;
+        static constexpr uint64_t HASH_BASE_INVERSE = [] {
+            // Newton's iteration doubles the number of correct low bits.
+            uint64_t inverse = HASH_BASE;
+            for (int i = 0; i < 5; i++)
+                inverse *= 2 - HASH_BASE * inverse;
+            return inverse;
+        }();
+        static_assert(HASH_BASE * HASH_BASE_INVERSE == 1);
+
+        size_t name_hash_;
+        uint64_t content_hash_ = 0;
+        // The sum of HASH_BASE^i over healthy and sweet fruits, which lets an
+        // infestation update `content_hash_` in O(1).
+        uint64_t healthy_sweet_hash_ = 0;
+        // HASH_BASE^count_fruits(), the weight of the next picked fruit.
+        uint64_t hash_power_ = 1;
+
+        // Builds rankings directly from the ranking criteria and identities.
+        friend class Ranking;
+
+        // Prints the pickers of a ranking with `write_to()`.
+        friend ostream& operator<<(ostream& os, const Ranking& ranking);
+
+        /// Formats the picker into `writer`, as `operator<<` prints it.
+        void write_to(hidden::buffered_writer& writer) const {
+            writer << name_ << ':';
 
-        unordered_map<Taste, size_t> cnt_taste_;
-        unordered_map<Size, size_t> cnt_size_;
-        unordered_map<Quality, size_t> cnt_quality_;
+            // List each picked fruit on a separate tab-indented line.
+            // No newline (LF) on the last line.
+            for (size_t i = 0; i < count_fruits(); i++) {
+                writer << "\n\t" << fruit_at(i);
+            }
+        }
 
-        /// Increments counters for taste, size and quality of a given `fruit`.
-        void count_added_fruit(const Fruit& fruit) {
-            cnt_taste_[fruit.taste()]++;
-            cnt_size_[fruit.size()]++;
-            cnt_quality_[fruit.quality()]++;
+        static constexpr uint64_t fruit_code(const Fruit& fruit) noexcept {
+            return 1 + std::to_underlying(fruit.taste())
+                     + 2 * std::to_underlying(fruit.size())
+                     + 8 * std::to_underlying(fruit.quality());
+        }
+
+        /**
+         * Increments counters for taste, size and quality of a given `fruit`
+         * and adds it to the hashes with a given `weight` (HASH_BASE^index).
+         */
+        void count_added_fruit(const Fruit& fruit,
+                               const uint64_t weight) noexcept {
+            cnt_taste_[std::to_underlying(fruit.taste())]++;
+            cnt_size_[std::to_underlying(fruit.size())]++;
+            cnt_quality_[std::to_underlying(fruit.quality())]++;
+            content_hash_ += fruit_code(fruit) * weight;
+
+            if (iw_healthy(fruit) && is_sweet(fruit)) {
+                cnt_healthy_sweet_++;
+                healthy_sweet_hash_ += weight;
+            }
+        }
+
+        /**
+         * Decrements counters for taste, size and quality of a given `fruit`
+         * and removes it from the hashes with a given `weight`.
+         */
+        void count_removed_fruit(const Fruit& fruit,
+                                 const uint64_t weight) noexcept {
+            cnt_taste_[std::to_underlying(fruit.taste())]--;
+            cnt_size_[std::to_underlying(fruit.size())]--;
+            cnt_quality_[std::to_underlying(fruit.quality())]--;
+            content_hash_ -= fruit_code(fruit) * weight;
+
+            if (iw_healthy(fruit) && is_sweet(fruit)) {
+                cnt_healthy_sweet_--;
+                healthy_sweet_hash_ -= weight;
+            }
         }
 
-        /// Decrements counters for taste, size and quality of a given `fruit`.
-        void count_removed_fruit(const Fruit& fruit) {
-            cnt_taste_[fruit.taste()]--;
-            cnt_size_[fruit.size()]--;
-            cnt_quality_[fruit.quality()]--;
+        /// Returns a hash identifying pickers equal to this one.
+        uint64_t identity() const noexcept {
+            // Mix both hashes with the splitmix64 finalizer.
+            uint64_t x = content_hash_ ^ (name_hash_ * 0x9e3779b97f4a7c15);
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+            return x ^ (x >> 31);
         }
 
+        /// Recomputes the ranking criteria from the counters.
+        void update_rank_key() noexcept {
+            rank_key_ = {
+                count_quality(Quality::HEALTHY),
+                count_taste(Taste::SWEET),
+                count_size(Size::LARGE),
+                count_size(Size::MEDIUM),
+                count_size(Size::SMALL),
+                count_fruits()
+            };
+        }
+
+        /// Returns the fruit at a given `index` with its actual quality.
+        Fruit fruit_at(const size_t index) const {
+            Fruit fruit = picked_fruits_[first_fruit_ + index];
+
+            if (index < infested_prefix_ && is_sweet(fruit))
+                fruit.become_worm_infested();
+
+            return fruit;
+        }
+
+        /// Makes all healthy and sweet fruits picked so far wormy in O(1).
+        void infest_healthy_sweet() noexcept {
+            // Infestation changes the code of every such fruit by the same
+            // amount, regardless of its size.
+            constexpr uint64_t code_change =
+                fruit_code(Fruit(Taste::SWEET, Size::LARGE, Quality::WORMY))
+                - fruit_code(YUMMY_ONE);
+
+            cnt_quality_[std::to_underlying(Quality::HEALTHY)] -=
+                cnt_healthy_sweet_;
+            cnt_quality_[std::to_underlying(Quality::WORMY)] +=
+                cnt_healthy_sweet_;
+            cnt_healthy_sweet_ = 0;
+            content_hash_ += code_change * healthy_sweet_hash_;
+            healthy_sweet_hash_ = 0;
+            infested_prefix_ = count_fruits();
+        }
+
+        /// Removes the first fruit in amortized O(1).
+        void pop_first_fruit() noexcept {
+            // The removed prefix is dropped once it makes up half of the
+            // vector, so each removal moves at most one remaining fruit.
+            if (++first_fruit_ * 2 >= picked_fruits_.size()) {
+                picked_fruits_.erase(picked_fruits_.begin(),
+                                     picked_fruits_.begin() + first_fruit_);
+                first_fruit_ = 0;
+            }
+        }
+
+        /// Updates the hashes after the first fruit has been removed.
+        void shift_hashes() noexcept {
+            content_hash_ *= HASH_BASE_INVERSE;
+            healthy_sweet_hash_ *= HASH_BASE_INVERSE;
+            hash_power_ *= HASH_BASE_INVERSE;
+        }
+
+
         static bool is_sweet(const Fruit& fruit) {
             return fruit.taste() == Taste::SWEET;
         }
@@ -195,15 +411,50 @@ class Picker {
 
     public:
         explicit Picker(string_view name = {})
-            : name_(name.empty() ? string("Anonim") : string(name)) {}
-    
+            : name_(name.empty() ? string("Anonim") : string(name)),
+              name_hash_(std::hash<string>{}(name_)) {}
+
         Picker(const Picker&) = default;
 
-        Picker(Picker&&) noexcept = default;
+        Picker(Picker&& other) noexcept
+            : name_(move(other.name_)),
+              picked_fruits_(move(other.picked_fruits_)),
+              first_fruit_(std::exchange(other.first_fruit_, 0)),
+              infested_prefix_(std::exchange(other.infested_prefix_, 0)),
+              cnt_taste_(std::exchange(other.cnt_taste_, {})),
+              cnt_size_(std::exchange(other.cnt_size_, {})),
+              cnt_quality_(std::exchange(other.cnt_quality_, {})),
+              cnt_healthy_sweet_(std::exchange(other.cnt_healthy_sweet_, 0)),
+              rank_key_(std::exchange(other.rank_key_, {})),
+              name_hash_(std::exchange(other.name_hash_,
+                                       std::hash<string>{}(other.name_))),
+              content_hash_(std::exchange(other.content_hash_, 0)),
+              healthy_sweet_hash_(std::exchange(other.healthy_sweet_hash_, 0)),
+              hash_power_(std::exchange(other.hash_power_, 1)) {}
 
         Picker& operator=(const Picker&) = default;
 
-        Picker& operator=(Picker&&) noexcept = default;
+        Picker& operator=(Picker&& other) noexcept {
+            if (this != &other) {
+                name_ = move(other.name_);
+                picked_fruits_ = move(other.picked_fruits_);
+                first_fruit_ = std::exchange(other.first_fruit_, 0);
+                infested_prefix_ = std::exchange(other.infested_prefix_, 0);
+                cnt_taste_ = std::exchange(other.cnt_taste_, {});
+                cnt_size_ = std::exchange(other.cnt_size_, {});
+                cnt_quality_ = std::exchange(other.cnt_quality_, {});
+                cnt_healthy_sweet_ = std::exchange(other.cnt_healthy_sweet_, 0);
+                rank_key_ = std::exchange(other.rank_key_, {});
+                name_hash_ = std::exchange(other.name_hash_,
+                                           std::hash<string>{}(other.name_));
+                content_hash_ = std::exchange(other.content_hash_, 0);
+                healthy_sweet_hash_ =
+                    std::exchange(other.healthy_sweet_hash_, 0);
+                hash_power_ = std::exchange(other.hash_power_, 1);
+            }
+
+            return *this;
+        }
 
         string get_name() const {
             return name_;
@@ -213,41 +464,41 @@ class Picker {
             requires derived_from<remove_cvref_t<T>, Fruit>
         Picker& operator+=(T&& fruit) {
             // Add the picked fruit and update its count.
+            const uint64_t weight = hash_power_;
             picked_fruits_.push_back(forward<T>(fruit));
-            count_added_fruit(picked_fruits_.back());
+            hash_power_ *= HASH_BASE;
+            count_added_fruit(picked_fruits_.back(), weight);
 
-            if (picked_fruits_.size() >= 2) {
+            if (count_fruits() >= 2) {
                 Fruit& last = picked_fruits_.back();
-                Fruit& prev_last = *prev(picked_fruits_.end(), 2);
+                const size_t prev_index = count_fruits() - 2;
+                const uint64_t prev_weight = weight * HASH_BASE_INVERSE;
+                const Fruit prev_last = fruit_at(prev_index);
 
                 // If the new fruit is healthy and the previous one was rotten,
                 // the new fruit becomes rotten.
                 if (iw_healthy(last) && is_rotten(prev_last)) {
-                    count_removed_fruit(last);
+                    count_removed_fruit(last, weight);
                     last.go_rotten();
-                    count_added_fruit(last);
+                    count_added_fruit(last, weight);
                 }
 
                 // If the new fruit is rotten and the previous one was healthy,
                 // the previous fruit becomes rotten.
                 else if (is_rotten(last) && iw_healthy(prev_last)) {
-                    count_removed_fruit(prev_last);
-                    prev_last.go_rotten();
-                    count_added_fruit(prev_last);
+                    count_removed_fruit(prev_last, prev_weight);
+                    picked_fruits_[first_fruit_ + prev_index].go_rotten();
+                    count_added_fruit(fruit_at(prev_index), prev_weight);
                 }
 
                 // If the new fruit is wormy, all previously collected healthy
                 // and sweet fruits become wormy.
                 else if (is_wormy(last)) {
-                    for (Fruit& f : picked_fruits_)
-                        if (iw_healthy(f) && is_sweet(f)) {
-                            count_removed_fruit(f);
-                            f.become_worm_infested();
-                            count_added_fruit(f);
-                        }
+                    infest_healthy_sweet();
                 }
             }
 
+            update_rank_key();
             return *this;
         }
 
@@ -256,14 +507,20 @@ class Picker {
               && (!is_const_v<remove_reference_t<T>>)
         Picker& operator+=(T&& other) {
             // Skip if trying to steal from self or if `other` has no fruits.
-            if (this == &other || other.picked_fruits_.empty())
+            if (this == &other || other.count_fruits() == 0)
                 return *this;
 
-            Fruit stolen = move(other.picked_fruits_.front());
+            const Fruit stolen = other.fruit_at(0);
 
             // Remove the stolen fruit from `other` and update its count.
-            other.picked_fruits_.pop_front();
-            other.count_removed_fruit(stolen);
+            other.pop_first_fruit();
+            other.count_removed_fruit(stolen, 1);
+            other.shift_hashes();
+
+            if (other.infested_prefix_ > 0)
+                other.infested_prefix_--;
+
+            other.update_rank_key();
 
             return *this += stolen;
         }
@@ -278,145 +535,880 @@ class Picker {
 
         /// Returns the total number of picked fruits.
         size_t count_fruits() const noexcept {
-            return picked_fruits_.size();
+            return picked_fruits_.size() - first_fruit_;
         }
 
         /// Returns the number of picked fruits that have a given `taste`.
         size_t count_taste(const Taste& taste) const noexcept {
-            auto it = cnt_taste_.find(taste);
-            return (it != cnt_taste_.end()) ? it->second : 0;
+            return cnt_taste_[std::to_underlying(taste)];
         }
 
         /// Returns the number of picked fruits that have a given `size`.
         size_t count_size(const Size& size) const noexcept {
-            auto it = cnt_size_.find(size);
-            return (it != cnt_size_.end()) ? it->second : 0;
+            return cnt_size_[std::to_underlying(size)];
         }
 
         /// Returns the number of picked fruits that have a given `quality`.
         size_t count_quality(const Quality& quality) const noexcept {
-            auto it = cnt_quality_.find(quality);
-            return (it != cnt_quality_.end()) ? it->second : 0;
+            return cnt_quality_[std::to_underlying(quality)];
         }
 
         /// Sorts pickers in descending order - less means a better picker.
-        weak_ordering operator<=>(const Picker& other) const {
-            if (auto c = other.count_quality(Quality::HEALTHY)
-                           <=> count_quality(Quality::HEALTHY); c != 0) 
-                return c;
+        weak_ordering operator<=>(const Picker& other) const noexcept {
+            return other.rank_key_ <=> rank_key_;
+        }
+
+        bool operator==(const Picker& other) const {
+            // Differing hashes rule out equality without comparing fruits.
+            if (name_hash_ != other.name_hash_
+                || content_hash_ != other.content_hash_
+                || name_ != other.name_
+                || count_fruits() != other.count_fruits())
+                return false;
+
+            for (size_t i = 0; i < count_fruits(); i++)
+                if (fruit_at(i) != other.fruit_at(i))
+                    return false;
+
+            return true;
+        }
+
+        friend ostream& operator<<(ostream& os, const Picker& picker) {
+            hidden::buffered_writer writer(os);
+            picker.write_to(writer);
+            writer.flush();
+            return os;
+        }
+};
+
+namespace hidden {
+    /**
+     * Order-statistics tree: a treap whose nodes know the size of their
+     * subtree and their parent. Access by position, the position of a node,
+     * insertion and removal are O(log n) expected.
+     *
+     * Elements equivalent under `Compare` are kept in insertion order. Nodes
+     * never move in memory, so pointers to them stay valid until they are
+     * erased from the tree.
+     */
+    template <typename T, typename Compare>
+    class ranked_tree {
+        public:
+            struct node {
+                T value;
+                node* parent = nullptr;
+                node* left = nullptr;
+                node* right = nullptr;
+                size_t size = 1;
+                uint64_t priority = 0;
+            };
+
+            /// Bidirectional iterator over the values in sorted order.
+            class const_iterator {
+                private:
+                    const ranked_tree* tree_ = nullptr;
+                    node* node_ = nullptr;
+
+                    friend class ranked_tree;
+
+                    const_iterator(const ranked_tree* tree, node* n)
+                        : tree_(tree), node_(n) {}
+
+                public:
+                    using iterator_category = std::bidirectional_iterator_tag;
+                    using value_type = T;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const T*;
+                    using reference = const T&;
+
+                    const_iterator() = default;
+
+                    reference operator*() const {
+                        return node_->value;
+                    }
+
+                    pointer operator->() const {
+                        return &node_->value;
+                    }
+
+                    const_iterator& operator++() {
+                        node_ = successor(node_);
+                        return *this;
+                    }
+
+                    const_iterator operator++(int) {
+                        const_iterator old = *this;
+                        ++*this;
+                        return old;
+                    }
+
+                    const_iterator& operator--() {
+                        node_ = node_ ? predecessor(node_)
+                                      : rightmost(tree_->root_);
+                        return *this;
+                    }
+
+                    const_iterator operator--(int) {
+                        const_iterator old = *this;
+                        --*this;
+                        return old;
+                    }
+
+                    bool operator==(const const_iterator& other) const {
+                        return node_ == other.node_;
+                    }
+
+                    /// Returns the node the iterator points to.
+                    node* get_node() const noexcept {
+                        return node_;
+                    }
+            };
+
+        private:
+            node* root_ = nullptr;
+            uint64_t seed_ = 0x9e3779b97f4a7c15;
+            [[no_unique_address]] Compare compare_;
+
+            /// Returns the next pseudo-random priority (xorshift64).
+            uint64_t next_priority() noexcept {
+                seed_ ^= seed_ << 13;
+                seed_ ^= seed_ >> 7;
+                seed_ ^= seed_ << 17;
+                return seed_;
+            }
+
+            static size_t size_of(const node* n) noexcept {
+                return n ? n->size : 0;
+            }
+
+            static void update_size(node* n) noexcept {
+                n->size = 1 + size_of(n->left) + size_of(n->right);
+            }
+
+            static node* leftmost(node* n) noexcept {
+                while (n && n->left)
+                    n = n->left;
+
+                return n;
+            }
+
+            static node* rightmost(node* n) noexcept {
+                while (n && n->right)
+                    n = n->right;
+
+                return n;
+            }
+
+            /// Puts `child` in the place of `n` under the parent of `n`.
+            void replace_child(node* n, node* child) noexcept {
+                if (child)
+                    child->parent = n->parent;
+
+                if (!n->parent)
+                    root_ = child;
+                else if (n->parent->left == n)
+                    n->parent->left = child;
+                else
+                    n->parent->right = child;
+            }
+
+            /// Lifts the right child of `n` above it.
+            void rotate_left(node* n) noexcept {
+                node* r = n->right;
+
+                n->right = r->left;
+                if (r->left)
+                    r->left->parent = n;
+
+                replace_child(n, r);
+                r->left = n;
+                n->parent = r;
+
+                update_size(n);
+                update_size(r);
+            }
+
+            /// Lifts the left child of `n` above it.
+            void rotate_right(node* n) noexcept {
+                node* l = n->left;
+
+                n->left = l->right;
+                if (l->right)
+                    l->right->parent = n;
+
+                replace_child(n, l);
+                l->right = n;
+                n->parent = l;
+
+                update_size(n);
+                update_size(l);
+            }
+
+            static node* clone(const node* src, node* parent) {
+                if (!src)
+                    return nullptr;
+
+                node* n = new node{src->value, parent, nullptr, nullptr,
+                                   src->size, src->priority};
+
+                try {
+                    n->left = clone(src->left, n);
+                    n->right = clone(src->right, n);
+                } catch (...) {
+                    destroy(n);
+                    throw;
+                }
+
+                return n;
+            }
+
+            static void destroy(node* n) noexcept {
+                if (!n)
+                    return;
+
+                destroy(n->left);
+                destroy(n->right);
+                delete n;
+            }
+
+            static size_t fix_sizes(node* n) noexcept {
+                if (!n)
+                    return 0;
+
+                n->size = 1 + fix_sizes(n->left) + fix_sizes(n->right);
+                return n->size;
+            }
+
+            /**
+             * Links sorted detached `nodes` into a new tree in O(n), using
+             * `spine` (with enough capacity for all nodes) as a stack.
+             */
+            void link_sorted(const vector<node*>& nodes,
+                             vector<node*>& spine) noexcept {
+                // Build the Cartesian tree of priorities along the right spine.
+                for (node* n : nodes) {
+                    node* last = nullptr;
+
+                    n->priority = next_priority();
+                    n->parent = n->left = n->right = nullptr;
+
+                    while (!spine.empty()
+                           && spine.back()->priority < n->priority) {
+                        last = spine.back();
+                        spine.pop_back();
+                    }
+
+                    n->left = last;
+                    if (last)
+                        last->parent = n;
+
+                    if (!spine.empty()) {
+                        spine.back()->right = n;
+                        n->parent = spine.back();
+                    }
+
+                    spine.push_back(n);
+                }
+
+                root_ = spine.empty() ? nullptr : spine.front();
+                fix_sizes(root_);
+            }
+
+        public:
+            ranked_tree() = default;
+
+            ranked_tree(const ranked_tree& other)
+                : root_(clone(other.root_, nullptr)), seed_(other.seed_),
+                  compare_(other.compare_) {}
+
+            ranked_tree(ranked_tree&& other) noexcept
+                : root_(std::exchange(other.root_, nullptr)),
+                  seed_(other.seed_), compare_(move(other.compare_)) {}
+
+            ranked_tree& operator=(const ranked_tree& other) {
+                if (this != &other) {
+                    ranked_tree copy(other);
+                    swap(copy);
+                }
+
+                return *this;
+            }
+
+            ranked_tree& operator=(ranked_tree&& other) noexcept {
+                if (this != &other) {
+                    clear();
+                    swap(other);
+                }
+
+                return *this;
+            }
+
+            ~ranked_tree() {
+                clear();
+            }
+
+            void swap(ranked_tree& other) noexcept {
+                std::swap(root_, other.root_);
+                std::swap(seed_, other.seed_);
+                std::swap(compare_, other.compare_);
+            }
+
+            void clear() noexcept {
+                destroy(root_);
+                root_ = nullptr;
+            }
+
+            size_t size() const noexcept {
+                return size_of(root_);
+            }
+
+            bool empty() const noexcept {
+                return !root_;
+            }
+
+            const_iterator begin() const noexcept {
+                return const_iterator(this, leftmost(root_));
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator(this, nullptr);
+            }
+
+            /// Returns the node following `n` in sorted order, or null.
+            static node* successor(node* n) noexcept {
+                if (n->right)
+                    return leftmost(n->right);
+
+                while (n->parent && n == n->parent->right)
+                    n = n->parent;
+
+                return n->parent;
+            }
+
+            /// Returns the node preceding `n` in sorted order, or null.
+            static node* predecessor(node* n) noexcept {
+                if (n->left)
+                    return rightmost(n->left);
+
+                while (n->parent && n == n->parent->left)
+                    n = n->parent;
+
+                return n->parent;
+            }
+
+            /// Returns an iterator to the given node.
+            const_iterator iterator_to(node* n) const noexcept {
+                return const_iterator(this, n);
+            }
+
+            /**
+             * Links a detached node into the tree, after all the elements
+             * equivalent to it.
+             */
+            void insert_node(node* n) noexcept {
+                n->left = n->right = nullptr;
+                n->size = 1;
+                n->priority = next_priority();
+
+                node* parent = nullptr;
+                bool to_left = false;
+
+                for (node* cur = root_; cur; ) {
+                    parent = cur;
+                    cur->size++;
+                    to_left = compare_(n->value, cur->value);
+                    cur = to_left ? cur->left : cur->right;
+                }
+
+                n->parent = parent;
+                if (!parent)
+                    root_ = n;
+                else if (to_left)
+                    parent->left = n;
+                else
+                    parent->right = n;
+
+                // Restore the heap order of priorities.
+                while (n->parent && n->parent->priority < n->priority) {
+                    if (n->parent->left == n)
+                        rotate_right(n->parent);
+                    else
+                        rotate_left(n->parent);
+                }
+            }
+
+            /// Unlinks a node from the tree without destroying it.
+            void extract_node(node* n) noexcept {
+                // Push the node down until it has at most one child.
+                while (n->left && n->right) {
+                    if (n->left->priority > n->right->priority)
+                        rotate_right(n);
+                    else
+                        rotate_left(n);
+                }
+
+                replace_child(n, n->left ? n->left : n->right);
+
+                for (node* cur = n->parent; cur; cur = cur->parent)
+                    cur->size--;
+
+                n->parent = n->left = n->right = nullptr;
+                n->size = 1;
+            }
+
+            /// Constructs a value in a new detached node.
+            template <typename... Args>
+            static node* make_node(Args&&... args) {
+                return new node{T(forward<Args>(args)...)};
+            }
+
+            /// Constructs a value in a new node and links it into the tree.
+            template <typename... Args>
+            node* emplace(Args&&... args) {
+                node* n = make_node(forward<Args>(args)...);
+                insert_node(n);
+                return n;
+            }
+
+            void erase(node* n) noexcept {
+                extract_node(n);
+                delete n;
+            }
+
+            /// Returns the node at a given position (0-based).
+            node* at(size_t index) const noexcept {
+                node* cur = root_;
+
+                while (cur) {
+                    const size_t left_size = size_of(cur->left);
+
+                    if (index < left_size) {
+                        cur = cur->left;
+                    } else if (index == left_size) {
+                        return cur;
+                    } else {
+                        index -= left_size + 1;
+                        cur = cur->right;
+                    }
+                }
 
-            if (auto c = other.count_taste(Taste::SWEET) 
-                            <=> count_taste(Taste::SWEET); c != 0)
-                return c;
+                return nullptr;
+            }
+
+            /// Returns the position (0-based) of a node in the tree.
+            static size_t rank(const node* n) noexcept {
+                size_t result = size_of(n->left);
+
+                for (; n->parent; n = n->parent)
+                    if (n == n->parent->right)
+                        result += size_of(n->parent->left) + 1;
+
+                return result;
+            }
+
+            /**
+             * Returns the first node whose value does not satisfy `pred`, where
+             * `pred` holds for a prefix of the sorted values.
+             */
+            template <typename Pred>
+            node* partition_point(Pred pred) const {
+                node* result = nullptr;
+
+                for (node* cur = root_; cur; ) {
+                    if (pred(cur->value)) {
+                        cur = cur->right;
+                    } else {
+                        result = cur;
+                        cur = cur->left;
+                    }
+                }
+
+                return result;
+            }
+
+            /// Returns all nodes in sorted order, leaving them in the tree.
+            vector<node*> nodes() const {
+                vector<node*> result;
+                result.reserve(size());
+
+                for (node* n = leftmost(root_); n; n = successor(n))
+                    result.push_back(n);
 
-            if (auto c = other.count_size(Size::LARGE)
-                            <=> count_size(Size::LARGE); c != 0)
-                return c;
+                return result;
+            }
+
+            /// Detaches all nodes and returns them in sorted order.
+            vector<node*> release() {
+                vector<node*> result = nodes();
+                root_ = nullptr;
+                return result;
+            }
 
-            if (auto c = other.count_size(Size::MEDIUM)
-                            <=> count_size(Size::MEDIUM); c != 0)
-                return c;
+            /**
+             * Replaces the contents of an empty tree with the detached `nodes`,
+             * which must be sorted. Runs in O(n). If an exception is thrown,
+             * the nodes stay detached.
+             */
+            void build(const vector<node*>& nodes) {
+                vector<node*> spine;
+                spine.reserve(nodes.size());
+                link_sorted(nodes, spine);
+            }
 
-            if (auto c = other.count_size(Size::SMALL)
-                            <=> count_size(Size::SMALL); c != 0)
-                return c;
+            /**
+             * Replaces the contents of an empty tree with the detached `nodes`
+             * in any order, which are sorted in place. Equivalent nodes keep
+             * their relative order. If an exception is thrown, `nodes` still
+             * holds all the nodes, which stay detached.
+             */
+            void build_unsorted(vector<node*>& nodes) {
+                std::stable_sort(nodes.begin(), nodes.end(),
+                    [this](const node* a, const node* b) {
+                        return compare_(a->value, b->value);
+                    });
+
+                build(nodes);
+            }
 
-            if (auto c = other.count_fruits()
-                            <=> count_fruits(); c != 0)
-                return c;
+            /**
+             * Moves all nodes of `other` into this tree in O(n + m). Nodes of
+             * this tree precede equivalent nodes of `other`.
+             */
+            void merge(ranked_tree&& other) {
+                // Allocate everything up front, so that nothing can throw
+                // once the nodes are detached.
+                const vector<node*> lhs = nodes();
+                const vector<node*> rhs = other.nodes();
+                vector<node*> merged, spine;
+                merged.reserve(lhs.size() + rhs.size());
+                spine.reserve(lhs.size() + rhs.size());
+
+                std::merge(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                    std::back_inserter(merged),
+                    [this](const node* a, const node* b) {
+                        return compare_(a->value, b->value);
+                    });
+
+                root_ = other.root_ = nullptr;
+                link_sorted(merged, spine);
+            }
+
+            const Compare& compare() const noexcept {
+                return compare_;
+            }
+    };
+} /* namespace hidden */
+
+class Ranking {
+    private:
+        using tree_t = hidden::ranked_tree<Picker, std::less<Picker>>;
+        using node_t = tree_t::node;
 
-            return weak_ordering::equivalent;
+        using index_t = std::unordered_multimap<uint64_t, node_t*>;
+
+        tree_t pickers_;
+        // Nodes by the identities of their pickers, for lookups by value.
+        index_t index_;
+
+        /// Returns the highest ranked node equal to `picker`, or null.
+        node_t* find_node(const Picker& picker) const {
+            node_t* result = nullptr;
+            size_t result_rank = 0;
+
+            // Only the (few) pickers with the same identity may be equal.
+            const auto [first, last] = index_.equal_range(picker.identity());
+
+            for (auto it = first; it != last; ++it) {
+                if (!(it->second->value == picker))
+                    continue;
+
+                const size_t rank = tree_t::rank(it->second);
+
+                if (!result || rank < result_rank) {
+                    result = it->second;
+                    result_rank = rank;
+                }
+            }
+
+            return result;
         }
 
-        bool operator==(const Picker& other) const {
-            return name_ == other.name_ 
-                && picked_fruits_ == other.picked_fruits_;
+        /// Returns the index entry of a node whose picker has `identity`.
+        index_t::iterator index_entry(const node_t* n,
+                                      const uint64_t identity) {
+            auto [it, last] = index_.equal_range(identity);
+
+            while (it->second != n)
+                ++it;
+
+            return it;
         }
 
-        friend ostream& operator<<(ostream& os, const Picker& picker) {
-            os << picker.get_name() << ':';
+        /// Indexes a detached node and links it into the tree.
+        node_t* link_node(node_t* n) {
+            index_.emplace(n->value.identity(), n);
+            pickers_.insert_node(n);
+            return n;
+        }
 
-            // List each picked fruit on a separate tab-indented line.
-            // No newline (LF) on the last line.
-            for (const Fruit& fruit : picker.picked_fruits_) {
-                os << "\n\t" << fruit;
+        /// Constructs a picker in a new node and links it into the ranking.
+        template <typename T>
+        node_t* emplace(T&& picker) {
+            node_t* n = tree_t::make_node(forward<T>(picker));
+
+            try {
+                return link_node(n);
+            } catch (...) {
+                delete n;
+                throw;
             }
+        }
 
-            return os;
+        void erase(node_t* n) noexcept {
+            index_.erase(index_entry(n, n->value.identity()));
+            pickers_.erase(n);
         }
-};
 
-class Ranking {
-    private:
-        multiset<Picker> pickers_;
+        /**
+         * Indexes detached `nodes` in any order and links them into the empty
+         * ranking; `sorted` tells whether they are already sorted. The nodes
+         * are destroyed if an exception is thrown.
+         */
+        void build(vector<node_t*>& nodes, const bool sorted) {
+            try {
+                // Index first: the tree takes ownership only at the end.
+                index_.reserve(nodes.size());
+
+                for (node_t* n : nodes)
+                    index_.emplace(n->value.identity(), n);
+
+                if (sorted)
+                    pickers_.build(nodes);
+                else
+                    pickers_.build_unsorted(nodes);
+            } catch (...) {
+                index_.clear();
+
+                for (node_t* n : nodes)
+                    delete n;
+
+                throw;
+            }
+        }
+
+        /// Moves a node whose picker has changed to its new position.
+        void reposition(node_t* n) noexcept {
+            const node_t* prev_node = tree_t::predecessor(n);
+            const node_t* next_node = tree_t::successor(n);
+
+            if ((prev_node && n->value < prev_node->value)
+                || (next_node && next_node->value < n->value)) {
+                pickers_.extract_node(n);
+                pickers_.insert_node(n);
+            }
+        }
 
     public:
+        using const_iterator = tree_t::const_iterator;
+
+        /**
+         * Stable reference to a picker stored in a ranking. It stays valid
+         * until the picker is removed from the ranking; moving the ranking
+         * into another ranking keeps it valid (it then refers to the target).
+         */
+        class handle {
+            private:
+                node_t* node_ = nullptr;
+
+                friend class Ranking;
+
+                explicit handle(node_t* n) noexcept : node_(n) {}
+
+            public:
+                handle() = default;
+
+                /// Checks whether the handle refers to a picker.
+                explicit operator bool() const noexcept {
+                    return node_ != nullptr;
+                }
+
+                bool operator==(const handle& other) const = default;
+        };
+
         Ranking() = default;
 
+        /**
+         * Constructs a ranking from an unsorted range of pickers by sorting it
+         * once, in O(n log n). Use move iterators to avoid copying pickers.
+         */
+        template <std::input_iterator It, std::sentinel_for<It> S>
+            requires std::constructible_from<Picker, std::iter_reference_t<It>>
+        Ranking(It first, S last) {
+            vector<node_t*> nodes;
+
+            try {
+                for (; first != last; ++first) {
+                    nodes.push_back(nullptr);
+                    nodes.back() = tree_t::make_node(*first);
+                }
+            } catch (...) {
+                for (node_t* n : nodes)
+                    delete n;
+
+                throw;
+            }
+
+            build(nodes, false);
+        }
+
         /// Constructs a ranking from a list of pickers.
         Ranking(initializer_list<Picker> pickers_list)
-            : pickers_(pickers_list) {}
+            : Ranking(pickers_list.begin(), pickers_list.end()) {}
 
-        Ranking(const Ranking& ranking) = default;
+        /// Constructs a ranking from a vector of pickers, moving them.
+        explicit Ranking(vector<Picker>&& pickers)
+            : Ranking(std::make_move_iterator(pickers.begin()),
+                      std::make_move_iterator(pickers.end())) {}
+
+        /**
+         * Builds a ranking from a vector of pickers, moving them. The pickers
+         * are ordered by sorting their ranking criteria with the execution
+         * `policy` (e.g. `std::execution::par`), then linked in O(n).
+         * Defined in fruit_picking_par.h, which must be included to use it.
+         */
+        template <typename ExecutionPolicy>
+        static Ranking from_pickers(ExecutionPolicy&& policy,
+                                    vector<Picker>&& pickers);
+
+        Ranking(const Ranking& ranking) : pickers_(ranking.pickers_) {
+            // The copied tree has its own nodes, so index them anew.
+            index_.reserve(pickers_.size());
+
+            for (node_t* n : pickers_.nodes())
+                index_.emplace(n->value.identity(), n);
+        }
 
         Ranking(Ranking&& ranking) noexcept = default;
 
-        Ranking& operator=(const Ranking& ranking) = default;
+        Ranking& operator=(const Ranking& ranking) {
+            if (this != &ranking)
+                *this = Ranking(ranking);
+
+            return *this;
+        }
 
         Ranking& operator=(Ranking&& ranking) noexcept = default;
 
         template <typename T>
             requires derived_from<remove_cvref_t<T>, Picker>
         Ranking& operator+=(T&& picker) {
-            pickers_.insert(forward<T>(picker));
+            emplace(forward<T>(picker));
             return *this;
         }
 
-        /// Removes the first occurence of `picker` from the ranking.
-        Ranking& operator-=(const Picker& picker) {
-            // Find the range of possible positions for the `picker`.
-            auto it_begin = pickers_.lower_bound(picker);
-            auto it_end = pickers_.upper_bound(picker);
-
-            // Iterate through the range and erase the first match.
-            for (auto it = it_begin; it != it_end; ++it)
-                if (*it == picker) {
-                    pickers_.erase(it);
-                    break;
-                }
+        /// Adds a picker to the ranking and returns a handle to it.
+        template <typename T>
+            requires derived_from<remove_cvref_t<T>, Picker>
+        handle add(T&& picker) {
+            return handle(emplace(forward<T>(picker)));
+        }
 
-            return *this;
+        /**
+         * Returns a handle to the highest ranked picker equal to `picker`, or
+         * an empty handle if there is no such picker in the ranking.
+         */
+        handle find(const Picker& picker) const {
+            return handle(find_node(picker));
         }
 
-        constexpr Ranking& operator+=(const Ranking& other) {
-            // Duplicate the ranking if added to self when copied.
-            if (this == &other) {
-                multiset<Picker> copy = pickers_;
-                pickers_.insert(copy.begin(), copy.end());
-                return *this;
+        /// Returns a read-only reference to the picker referred to by `h`.
+        const Picker& picker(const handle& h) const noexcept {
+            return h.node_->value;
+        }
+
+        /**
+         * Calls `modify` on the picker referred to by `h` in place and moves it
+         * to its new position in O(log n). Pickers are never copied. `modify`
+         * must not change any other picker in the ranking.
+         */
+        template <typename F>
+            requires std::invocable<F, Picker&>
+        void update(const handle& h, F&& modify) {
+            // Reindex the node under its new identity by moving its entry.
+            auto entry = index_.extract(
+                index_entry(h.node_, h.node_->value.identity()));
+
+            try {
+                std::invoke(forward<F>(modify), h.node_->value);
+            } catch (...) {
+                entry.key() = h.node_->value.identity();
+                index_.insert(move(entry));
+                reposition(h.node_);
+                throw;
             }
 
-            pickers_.insert(other.pickers_.begin(), other.pickers_.end());
+            entry.key() = h.node_->value.identity();
+            index_.insert(move(entry));
+            reposition(h.node_);
+        }
+
+        /// Removes the picker referred to by `h`, invalidating the handle.
+        void remove(const handle& h) noexcept {
+            erase(h.node_);
+        }
+
+        /// Returns the position (0-based) of the picker referred to by `h`.
+        size_t rank_of(const handle& h) const noexcept {
+            return tree_t::rank(h.node_);
+        }
+
+        /**
+         * Removes the first occurence of `picker` from the ranking. Candidates
+         * are found through the identity index in O(log n), so fruits are
+         * compared only for pickers that are almost certainly equal.
+         */
+        Ranking& operator-=(const Picker& picker) {
+            if (node_t* n = find_node(picker))
+                erase(n);
+
             return *this;
         }
 
-        constexpr Ranking& operator+=(Ranking&& other) {
+        Ranking& operator+=(const Ranking& other) {
+            // Copy `other` first, which also duplicates the ranking if added
+            // to self.
+            return *this += Ranking(other);
+        }
+
+        /**
+         * Moves all pickers of `other` into the ranking without copying them.
+         * Small rankings are inserted one by one in O(m log(n + m)), larger
+         * ones are merged in O(n + m).
+         */
+        Ranking& operator+=(Ranking&& other) {
             // Leave the ranking as is if added to self when moved.
             if (this == &other)
                 return *this;
 
-            // Move and merge `other` ranking into this ranking.
-            pickers_.insert(
-                make_move_iterator(other.pickers_.begin()),
-                make_move_iterator(other.pickers_.end())
-            );
+            const size_t n = pickers_.size(), m = other.pickers_.size();
+
+            // Reserve buckets up front, so that merging the index cannot fail.
+            index_.reserve(n + m);
+
+            if (m * std::bit_width(n + m) < n) {
+                for (node_t* node : other.pickers_.release())
+                    pickers_.insert_node(node);
+            } else {
+                pickers_.merge(move(other.pickers_));
+            }
 
+            index_.merge(other.index_);
             return *this;
         }
 
         /**
          * Returns a read-only reference to the picker at a given `index`
-         * (0-based).
+         * (0-based) in O(log n).
          * 
          * If the `index` is out of range, returns the last picker in the
          * ranking.
@@ -430,9 +1422,26 @@ class Ranking {
                 return dummy;
             }
 
-            auto it = pickers_.begin();
-            advance(it, min(index, pickers_.size() - 1));
-            return *it;
+            return pickers_.at(min(index, pickers_.size() - 1))->value;
+        }
+
+        /**
+         * Returns the position (0-based) of the highest ranked picker equal to
+         * `picker`, or `nullopt` if there is no such picker in the ranking.
+         */
+        optional<size_t> rank_of(const Picker& picker) const {
+            if (const node_t* n = find_node(picker))
+                return tree_t::rank(n);
+
+            return nullopt;
+        }
+
+        /// Returns the range of (at most) `k` best pickers in the ranking.
+        subrange<const_iterator> top(const size_t k) const {
+            if (k >= pickers_.size())
+                return {begin(), end()};
+
+            return {begin(), pickers_.iterator_to(pickers_.at(k))};
         }
 
         /// Returns the total number of pickers in the ranking.
@@ -440,12 +1449,24 @@ class Ranking {
             return pickers_.size();
         }
 
+        const_iterator begin() const noexcept {
+            return pickers_.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return pickers_.end();
+        }
+
         friend ostream& operator<<(ostream& os, const Ranking& ranking) {
+            hidden::buffered_writer writer(os);
+
             // List each picker on a separate line.
             for (const Picker& picker : ranking.pickers_) {
-                os << picker << '\n';
+                picker.write_to(writer);
+                writer << '\n';
             }
 
+            writer.flush();
             return os;
         }
 };
@@ -459,4 +1480,146 @@ Ranking operator+(T1&& lhs, T2&& rhs) {
     return result;
 }
 
+/**
+ * Ranking that accepts updates from many threads at once. Pickers are
+ * identified by their names and sharded by the names' hashes; each shard is
+ * guarded by its own mutex. Reads go through a consistent snapshot of all
+ * shards, rebuilt on demand only after the pickers have changed.
+ */
+class ConcurrentRanking {
+    private:
+        struct entry {
+            Picker picker;
+            // Position of the picker's first appearance, breaking ties.
+            uint64_t order;
+        };
+
+        struct shard {
+            mutable std::mutex mutex;
+            unordered_map<string, entry> pickers;
+        };
+
+        vector<shard> shards_;
+        std::atomic<uint64_t> next_order_ = 0;
+        std::atomic<uint64_t> version_ = 0;
+
+        mutable std::mutex snapshot_mutex_;
+        mutable shared_ptr<const Ranking> snapshot_;
+        mutable uint64_t snapshot_version_ = 0;
+
+        shard& shard_of(const string_view name) {
+            return shards_[std::hash<string_view>{}(name) % shards_.size()];
+        }
+
+    public:
+        /// Creates an empty ranking split into `shard_count` shards.
+        explicit ConcurrentRanking(
+            const size_t shard_count = std::thread::hardware_concurrency())
+            : shards_(std::max(shard_count, size_t{1})),
+              snapshot_(std::make_shared<const Ranking>()) {}
+
+        ConcurrentRanking(const ConcurrentRanking&) = delete;
+
+        ConcurrentRanking& operator=(const ConcurrentRanking&) = delete;
+
+        /**
+         * Calls `modify` on the picker named `name` under the lock of its
+         * shard, creating the picker first if there is no such picker yet.
+         */
+        template <typename F>
+            requires std::invocable<F, Picker&>
+        void update(const string_view name, F&& modify) {
+            shard& s = shard_of(name);
+            std::lock_guard lock(s.mutex);
+
+            // Snapshots read the version under all shard locks, so bumping it
+            // before the changes invalidates them even if `modify` throws
+            // after changing the picker.
+            version_++;
+
+            auto it = s.pickers.find(string(name));
+
+            if (it == s.pickers.end())
+                it = s.pickers.emplace(string(name),
+                                       entry{Picker(name), next_order_++})
+                         .first;
+
+            std::invoke(forward<F>(modify), it->second.picker);
+        }
+
+        /// Adds a picked fruit to the picker named `name`.
+        void add_fruit(const string_view name, const Fruit& fruit) {
+            update(name, [&fruit](Picker& picker) { picker += fruit; });
+        }
+
+        /// Removes the picker named `name`, if there is one.
+        void remove(const string_view name) {
+            shard& s = shard_of(name);
+            std::lock_guard lock(s.mutex);
+
+            if (s.pickers.erase(string(name)))
+                version_++;
+        }
+
+        /**
+         * Returns a consistent ranking of all pickers. The shards are locked
+         * together only while the pickers are copied; the result is cached
+         * until the next modification.
+         */
+        shared_ptr<const Ranking> snapshot() const {
+            std::lock_guard snapshot_lock(snapshot_mutex_);
+
+            if (snapshot_version_ == version_)
+                return snapshot_;
+
+            vector<std::pair<uint64_t, Picker>> copies;
+            uint64_t version;
+
+            {
+                vector<std::unique_lock<std::mutex>> locks;
+                locks.reserve(shards_.size());
+
+                // Always lock the shards in the same order.
+                for (const shard& s : shards_)
+                    locks.emplace_back(s.mutex);
+
+                version = version_;
+
+                for (const shard& s : shards_)
+                    for (const auto& [name, e] : s.pickers)
+                        copies.emplace_back(e.order, e.picker);
+            }
+
+            std::ranges::sort(copies, {}, &std::pair<uint64_t, Picker>::first);
+
+            vector<Picker> pickers;
+            pickers.reserve(copies.size());
+
+            for (auto& [order, picker] : copies)
+                pickers.push_back(move(picker));
+
+            snapshot_ = std::make_shared<const Ranking>(move(pickers));
+            snapshot_version_ = version;
+            return snapshot_;
+        }
+
+        /**
+         * Returns a copy of the picker at a given `index` (0-based) in the
+         * current snapshot; see `Ranking::operator[]`.
+         */
+        Picker operator[](const size_t index) const {
+            return (*snapshot())[index];
+        }
+
+        /// Returns the total number of pickers.
+        size_t count_pickers() const {
+            return snapshot()->count_pickers();
+        }
+
+        friend ostream& operator<<(ostream& os,
+                                   const ConcurrentRanking& ranking) {
+            return os << *ranking.snapshot();
+        }
+};
+
 #endif /* FRUIT_PICKING_H */
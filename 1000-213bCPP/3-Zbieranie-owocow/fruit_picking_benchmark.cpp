@@ -0,0 +1,154 @@
+#include "fruit_picking.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr std::size_t DEFAULT_MAX_PICKERS = 1'000'000;
+    constexpr std::size_t DEFAULT_MAX_FRUITS = 10'000'000;
+    constexpr std::size_t FRUITS_PER_PICKER = 8;
+    // Upper bound on repeated lookups and removals per configuration.
+    constexpr std::size_t MAX_QUERIES = 100'000;
+
+    std::mt19937_64 rng(2025);
+
+    // Results of measured reads end up here so they are not optimized away.
+    volatile std::size_t sink;
+
+    // Discards everything written to it.
+    class null_buffer : public std::streambuf {
+        protected:
+            int overflow(const int c) override {
+                return c;
+            }
+
+            std::streamsize xsputn(const char*, const std::streamsize n)
+                override {
+                return n;
+            }
+    };
+
+    Fruit random_fruit() {
+        return Fruit{static_cast<Taste>(rng() % 2), static_cast<Size>(rng() % 3),
+                     static_cast<Quality>(rng() % 3)};
+    }
+
+    std::vector<Fruit> random_fruits(const std::size_t count) {
+        std::vector<Fruit> fruits;
+        fruits.reserve(count);
+
+        for (std::size_t i = 0; i < count; i++)
+            fruits.push_back(random_fruit());
+
+        return fruits;
+    }
+
+    std::vector<Picker> random_pickers(const std::size_t count) {
+        std::vector<Picker> pickers;
+        pickers.reserve(count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            pickers.emplace_back("P" + std::to_string(i));
+
+            for (std::size_t j = 0; j < FRUITS_PER_PICKER; j++)
+                pickers.back() += random_fruit();
+        }
+
+        return pickers;
+    }
+
+    void print_header() {
+        std::cout << std::left << std::setw(22) << "operation" << std::right
+                  << std::setw(10) << "pickers" << std::setw(10) << "fruits"
+                  << std::setw(10) << "ops" << std::setw(12) << "ns/op"
+                  << std::setw(14) << "ops/s" << '\n';
+    }
+
+    // Runs `body` once, which performs `ops` operations, and prints a row.
+    template <typename F>
+    void measure(const char* operation, const std::size_t pickers,
+                 const std::size_t fruits, const std::size_t ops, F&& body) {
+        const auto start = clock_type::now();
+        body();
+        const std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+        std::cout << std::left << std::setw(22) << operation << std::right
+                  << std::setw(10) << pickers << std::setw(10) << fruits
+                  << std::setw(10) << ops << std::setw(12) << std::fixed
+                  << std::setprecision(1) << elapsed.count() * 1e9 / ops
+                  << std::setw(14) << std::setprecision(0)
+                  << ops / elapsed.count() << '\n';
+    }
+
+    void picker_benchmarks(const std::size_t fruit_count) {
+        const std::vector<Fruit> fruits = random_fruits(fruit_count);
+        Picker picker{"Bench"}, thief{"Thief"};
+
+        measure("Picker += Fruit", 1, fruit_count, fruit_count, [&] {
+            for (const Fruit& fruit : fruits)
+                picker += fruit;
+        });
+
+        measure("Picker += Picker", 2, fruit_count, fruit_count, [&] {
+            for (std::size_t i = 0; i < fruit_count; i++)
+                thief += picker;
+        });
+    }
+
+    void ranking_benchmarks(const std::size_t picker_count) {
+        const std::size_t fruits = picker_count * FRUITS_PER_PICKER;
+        const std::vector<Picker> pickers = random_pickers(picker_count);
+        const std::size_t queries = std::min(picker_count, MAX_QUERIES);
+        Ranking ranking;
+
+        measure("Ranking += Picker", picker_count, fruits, picker_count, [&] {
+            for (const Picker& picker : pickers)
+                ranking += picker;
+        });
+
+        measure("Ranking[]", picker_count, fruits, queries, [&] {
+            std::size_t total = 0;
+
+            for (std::size_t i = 0; i < queries; i++)
+                total += ranking[rng() % picker_count].count_fruits();
+
+            sink = total;
+        });
+
+        measure("Ranking << ostream", picker_count, fruits, picker_count, [&] {
+            null_buffer buffer;
+            std::ostream os(&buffer);
+            os << ranking;
+        });
+
+        measure("Ranking -= Picker", picker_count, fruits, queries, [&] {
+            for (std::size_t i = 0; i < queries; i++)
+                ranking -= pickers[i];
+        });
+    }
+} /* namespace */
+
+int main(int argc, char *argv[]) {
+    const std::size_t max_pickers =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_MAX_PICKERS;
+    const std::size_t max_fruits =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : DEFAULT_MAX_FRUITS;
+
+    print_header();
+
+    for (std::size_t fruits = 1000; fruits <= max_fruits; fruits *= 10)
+        picker_benchmarks(fruits);
+
+    for (std::size_t pickers = 10; pickers <= max_pickers; pickers *= 10)
+        ranking_benchmarks(pickers);
+}
@@ -0,0 +1,361 @@
+#include "fruit_picking.h"
+#include "fruit_picking_par.h"
+
+#ifdef NDEBUG
+    #undef NDEBUG
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <execution>
+#include <list>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::mt19937 rng(2025);
+
+    Fruit random_fruit() {
+        return Fruit{static_cast<Taste>(rng() % 2), static_cast<Size>(rng() % 3),
+                     static_cast<Quality>(rng() % 3)};
+    }
+
+    Picker random_picker(const std::size_t id) {
+        Picker picker{"P" + std::to_string(id % 7)};
+
+        for (std::size_t i = rng() % 4; i > 0; i--)
+            picker += random_fruit();
+
+        return picker;
+    }
+
+    // Straightforward implementation of the picking rules.
+    struct model_picker {
+        std::list<Fruit> fruits;
+
+        void add(Fruit fruit) {
+            fruits.push_back(fruit);
+
+            if (fruits.size() < 2)
+                return;
+
+            Fruit& last = fruits.back();
+            Fruit& prev_last = *std::prev(fruits.end(), 2);
+
+            if (last.quality() == Quality::HEALTHY
+                && prev_last.quality() == Quality::ROTTEN) {
+                last.go_rotten();
+            } else if (last.quality() == Quality::ROTTEN
+                       && prev_last.quality() == Quality::HEALTHY) {
+                prev_last.go_rotten();
+            } else if (last.quality() == Quality::WORMY) {
+                for (Fruit& f : fruits)
+                    if (f.taste() == Taste::SWEET)
+                        f.become_worm_infested();
+            }
+        }
+
+        std::size_t count(const Quality quality) const {
+            return std::ranges::count(fruits, quality, &Fruit::quality);
+        }
+    };
+
+    std::string to_string(const Picker& picker) {
+        std::ostringstream os;
+        os << picker;
+        return os.str();
+    }
+
+    std::string to_string(const model_picker& picker) {
+        std::ostringstream os;
+        os << "Anonim:";
+        for (const Fruit& fruit : picker.fruits)
+            os << "\n\t" << fruit;
+        return os.str();
+    }
+
+    void picker_examples() {
+        Picker pickers[3];
+        model_picker models[3];
+
+        for (std::size_t i = 0; i < 20000; i++) {
+            const std::size_t a = rng() % 3, b = rng() % 3;
+
+            if (rng() % 4 == 0) {
+                pickers[a] += pickers[b];
+
+                if (a != b && !models[b].fruits.empty()) {
+                    const Fruit stolen = models[b].fruits.front();
+                    models[b].fruits.pop_front();
+                    models[a].add(stolen);
+                }
+            } else {
+                // Favor healthy sweet fruits to make infestations matter.
+                const Fruit fruit = rng() % 2 ? YUMMY_ONE : random_fruit();
+                pickers[a] += fruit;
+                models[a].add(fruit);
+            }
+
+            const Picker& p = pickers[a];
+            const model_picker& m = models[a];
+            assert(p.count_fruits() == m.fruits.size());
+            assert(p.count_quality(Quality::HEALTHY)
+                   == m.count(Quality::HEALTHY));
+            assert(p.count_quality(Quality::ROTTEN)
+                   == m.count(Quality::ROTTEN));
+            assert(p.count_quality(Quality::WORMY) == m.count(Quality::WORMY));
+        }
+
+        for (std::size_t i = 0; i < 3; i++)
+            assert(to_string(pickers[i]) == to_string(models[i]));
+
+        // Pickers with equal fruits are equal however they got them, so that
+        // a ranking finds them by identity.
+        for (std::size_t i = 0; i < 1000; i++) {
+            Picker direct, stolen, thief;
+            stolen += YUMMY_ONE;
+
+            for (std::size_t j = rng() % 8; j > 0; j--) {
+                const Fruit fruit = random_fruit();
+                direct += fruit;
+                stolen += fruit;
+            }
+
+            thief += stolen;
+            assert(direct == stolen);
+
+            Ranking ranking{thief, stolen, thief};
+            ranking -= direct;
+            assert(ranking.count_pickers() == 2 && ranking[0] == thief);
+        }
+
+        // A moved-from picker starts over without pending infestations.
+        Picker moved = std::move(pickers[0]);
+        pickers[0] += YUMMY_ONE;
+        assert(pickers[0].count_quality(Quality::HEALTHY) == 1);
+    }
+
+    // Keeps `model` sorted the same way as `Ranking`: ties in insertion order.
+    void model_insert(std::vector<Picker>& model, const Picker& picker) {
+        model.insert(std::upper_bound(model.begin(), model.end(), picker),
+                     picker);
+    }
+
+    void model_erase(std::vector<Picker>& model, const Picker& picker) {
+        auto it = std::find(model.begin(), model.end(), picker);
+
+        if (it != model.end())
+            model.erase(it);
+    }
+
+    void assert_matches(const Ranking& ranking,
+                        const std::vector<Picker>& model) {
+        assert(ranking.count_pickers() == model.size());
+        assert(std::equal(ranking.begin(), ranking.end(), model.begin(),
+                          model.end()));
+
+        for (std::size_t i = 0; i < model.size(); i++)
+            assert(ranking[i] == model[i]);
+
+        // Checking every position would take quadratic time.
+        for (std::size_t i = 0; i < model.size(); i += 7) {
+            assert(ranking.rank_of(model[i])
+                   == std::find(model.begin(), model.end(), model[i])
+                      - model.begin());
+        }
+    }
+
+    void rank_examples() {
+        Ranking ranking;
+        std::vector<Picker> model;
+
+        for (std::size_t i = 0; i < 2000; i++) {
+            const Picker picker = random_picker(i);
+
+            if (rng() % 3 == 0) {
+                ranking -= picker;
+                model_erase(model, picker);
+            } else {
+                ranking += picker;
+                model_insert(model, picker);
+            }
+        }
+
+        assert_matches(ranking, model);
+        assert(ranking[model.size() + 5] == model.back());
+        assert(!ranking.rank_of(Picker{"Nobody"}).has_value());
+
+        const auto top = ranking.top(10);
+        assert(std::equal(top.begin(), top.end(), model.begin(),
+                          model.begin() + 10));
+        assert(std::ranges::distance(ranking.top(model.size() + 1))
+               == static_cast<std::ptrdiff_t>(model.size()));
+        assert(ranking.top(0).empty());
+
+        Ranking copy = ranking;
+        copy += ranking;
+        copy += std::move(ranking);
+        std::vector<Picker> doubled = model;
+        for (const Picker& picker : model)
+            model_insert(doubled, picker);
+        for (const Picker& picker : model)
+            model_insert(doubled, picker);
+        assert_matches(copy, doubled);
+    }
+
+    void bulk_examples() {
+        std::vector<Picker> pickers, model;
+
+        for (std::size_t i = 0; i < 3000; i++) {
+            pickers.push_back(random_picker(i));
+            model_insert(model, pickers.back());
+        }
+
+        const Ranking ranking{std::vector<Picker>(pickers)};
+        assert_matches(ranking, model);
+
+        const Ranking from_range(pickers.begin(), pickers.end());
+        assert_matches(from_range, model);
+
+        assert_matches(Ranking::from_pickers(std::execution::par,
+                                             std::vector<Picker>(pickers)),
+                       model);
+        assert_matches(Ranking::from_pickers(std::execution::seq,
+                                             std::vector<Picker>(pickers)),
+                       model);
+
+        // Merging keeps the pickers of the left ranking first among ties.
+        std::vector<Picker> merged = model;
+        for (const Picker& picker : pickers)
+            model_insert(merged, picker);
+        assert_matches(ranking + from_range, merged);
+
+        // A small ranking is inserted picker by picker.
+        Ranking big = ranking;
+        big += Ranking{pickers[0]};
+        model_insert(model, pickers[0]);
+        assert_matches(big, model);
+    }
+
+    void handle_examples() {
+        Ranking ranking;
+        std::vector<Ranking::handle> handles;
+
+        for (std::size_t i = 0; i < 500; i++)
+            handles.push_back(ranking.add(random_picker(i)));
+
+        for (std::size_t i = 0; i < 2000; i++) {
+            const Ranking::handle h = handles[rng() % handles.size()];
+            const Fruit fruit = random_fruit();
+
+            ranking.update(h, [&fruit](Picker& picker) { picker += fruit; });
+            assert(ranking[ranking.rank_of(h)] == ranking.picker(h));
+        }
+
+        // The pickers must still be sorted, ties keeping their relative order.
+        std::vector<Picker> model(ranking.begin(), ranking.end());
+        assert(std::is_sorted(model.begin(), model.end()));
+
+        for (std::size_t i = 0; i < model.size(); i++)
+            assert(ranking.find(model[i]));
+
+        const Ranking::handle first = ranking.find(ranking[0]);
+        assert(ranking.rank_of(first) == 0);
+        ranking.remove(first);
+        assert(ranking.count_pickers() == handles.size() - 1);
+        assert(!ranking.find(Picker{"Nobody"}));
+
+        // Handles survive moving the ranking into another one.
+        Ranking target{Picker{"Target"}};
+        const Ranking::handle last = ranking.find(ranking[model.size()]);
+        const Picker last_picker = ranking.picker(last);
+        target += std::move(ranking);
+        assert(target.picker(last) == last_picker);
+        assert(target.rank_of(last) < target.count_pickers());
+    }
+
+    void concurrent_examples() {
+        constexpr std::size_t THREADS = 4, NAMES = 50, FRUITS = 5000;
+        ConcurrentRanking ranking(8);
+        std::vector<Picker> expected;
+
+        // Every thread owns a disjoint set of names, so the final pickers do
+        // not depend on the interleaving.
+        for (std::size_t t = 0; t < THREADS; t++)
+            for (std::size_t n = 0; n < NAMES; n++)
+                expected.emplace_back("T" + std::to_string(t) + "N"
+                                      + std::to_string(n));
+
+        std::vector<std::vector<Fruit>> fruits(THREADS);
+        for (auto& thread_fruits : fruits)
+            for (std::size_t i = 0; i < FRUITS; i++)
+                thread_fruits.push_back(random_fruit());
+
+        for (std::size_t t = 0; t < THREADS; t++)
+            for (std::size_t i = 0; i < FRUITS; i++)
+                expected[t * NAMES + i % NAMES] += fruits[t][i];
+
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < THREADS; t++)
+            threads.emplace_back([&, t] {
+                for (std::size_t i = 0; i < FRUITS; i++) {
+                    ranking.add_fruit(expected[t * NAMES + i % NAMES]
+                                          .get_name(),
+                                      fruits[t][i]);
+
+                    // Snapshots may be taken while the pickers change.
+                    if (i % 1000 == 0)
+                        assert(std::ranges::is_sorted(*ranking.snapshot()));
+                }
+            });
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        const auto snapshot = ranking.snapshot();
+        assert(snapshot == ranking.snapshot());
+        assert(ranking.count_pickers() == expected.size());
+        assert(std::ranges::is_sorted(*snapshot));
+
+        for (const Picker& picker : expected)
+            assert(snapshot->find(picker));
+
+        ranking.remove(expected[0].get_name());
+        assert(ranking.count_pickers() == expected.size() - 1);
+        assert(ranking.snapshot() != snapshot);
+
+        // An update that throws after changing the picker still invalidates
+        // the cached snapshot.
+        const auto before = ranking.snapshot();
+        const std::string name = (*before)[0].get_name();
+        try {
+            ranking.update(name, [](Picker& picker) {
+                picker += YUMMY_ONE;
+                throw std::runtime_error("update failed");
+            });
+            assert(false);
+        }
+        catch (const std::runtime_error&) {}
+
+        const auto after = ranking.snapshot();
+        const auto by_name = [&](const Picker& picker) {
+            return picker.get_name() == name;
+        };
+        assert(after != before);
+        assert(std::ranges::find_if(*after, by_name)->count_fruits()
+               == (*before)[0].count_fruits() + 1);
+    }
+} // anonymous namespace
+
+int main() {
+    picker_examples();
+    rank_examples();
+    bulk_examples();
+    handle_examples();
+    concurrent_examples();
+}
@@ -0,0 +1,60 @@
+#ifndef FRUIT_PICKING_PAR_H
+#define FRUIT_PICKING_PAR_H
+
+// Parallel algorithms of the standard library may need an external backend
+// (e.g. TBB for libstdc++), so they are kept out of fruit_picking.h.
+
+#include "fruit_picking.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+template <typename ExecutionPolicy>
+Ranking Ranking::from_pickers(ExecutionPolicy&& policy,
+                              vector<Picker>&& pickers) {
+    static_assert(std::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>,
+                  "from_pickers requires an execution policy");
+
+    struct sort_entry {
+        Picker::rank_key_t key;
+        size_t index;
+    };
+
+    vector<sort_entry> entries(pickers.size());
+    vector<size_t> indices(pickers.size());
+    std::iota(indices.begin(), indices.end(), size_t{0});
+
+    std::transform(policy, indices.begin(), indices.end(), entries.begin(),
+        [&pickers](const size_t i) {
+            return sort_entry{pickers[i].rank_key_, i};
+        });
+
+    // Greater keys rank higher; ties keep the order of `pickers`.
+    std::sort(policy, entries.begin(), entries.end(),
+        [](const sort_entry& a, const sort_entry& b) {
+            return a.key != b.key ? a.key > b.key : a.index < b.index;
+        });
+
+    Ranking ranking;
+    vector<node_t*> nodes;
+    nodes.reserve(entries.size());
+
+    try {
+        for (const sort_entry& entry : entries)
+            nodes.push_back(tree_t::make_node(move(pickers[entry.index])));
+    } catch (...) {
+        for (node_t* n : nodes)
+            delete n;
+
+        throw;
+    }
+
+    ranking.build(nodes, true);
+    return ranking;
+}
+
+#endif /* FRUIT_PICKING_PAR_H */
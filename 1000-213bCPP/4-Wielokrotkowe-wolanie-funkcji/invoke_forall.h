@@ -10,7 +10,9 @@
  * get the result of the `i`-th invoke.
  *
  * The module also provides the `protect_arg()` function that makes
- * `invoke_forall` treat protected Gettable arguments as regular arguments.
+ * `invoke_forall` treat protected Gettable arguments as regular arguments,
+ * and the `broadcast_arg()` function that makes `invoke_forall_into` pass
+ * a range whole to every invoke.
  */
 
 #ifndef INVOKE_FORALL_H
@@ -20,6 +22,11 @@
 #include <concepts>
 #include <cstddef>
 #include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -36,11 +43,45 @@ struct protected_arg {
     explicit constexpr protected_arg(T&& arg) : value(std::forward<T>(arg)) {}
 };
 
+template <typename T>
+struct broadcasted_arg {
+    T value;
+    using is_broadcast_tag = void;
+
+    explicit constexpr broadcasted_arg(T&& arg) : value(std::forward<T>(arg)) {}
+};
+
+/**
+ * Wrapper of a callable that the user marked as safe to invoke concurrently
+ * with `concurrency_safe()`.
+ */
+template <typename F>
+struct concurrency_safe_callable {
+    F callable;
+    using is_concurrency_safe_tag = void;
+
+    template <typename T>
+    requires (!std::same_as<std::remove_cvref_t<T>, concurrency_safe_callable>)
+    explicit constexpr concurrency_safe_callable(T&& f)
+        : callable(std::forward<T>(f)) {}
+
+    template <typename... Args>
+    constexpr decltype(auto) operator()(Args&&...args) const
+    {
+        return std::invoke(callable, std::forward<Args>(args)...);
+    }
+};
+
 /** Satisfied if `T` is protected by `protect_arg()`. */
 template <typename T>
 concept Protected =
     requires { typename std::remove_cvref_t<T>::is_protected_tag; };
 
+/** Satisfied if `T` is marked by `broadcast_arg()`. */
+template <typename T>
+concept Broadcast =
+    requires { typename std::remove_cvref_t<T>::is_broadcast_tag; };
+
 template <typename T>
 concept HasTupleSize =
     requires { typename std::tuple_size<std::remove_cvref_t<T>>; };
@@ -65,24 +106,96 @@ concept TupleLike = HasTupleSizeDerivedFromIntegralConstant<T>;
 template <std::size_t I, typename T>
 concept HasGet = requires(T t) { (void)std::get<I>(t); };
 
+/**
+ * True if `std::get<i>(t)` is valid for all indices
+ * `0 ≤ i < std::tuple_size_v<T>`.
+ *
+ * `HasGet` takes `t` as an lvalue, so the result is the same for `T`, `T&`
+ * and `T&&`. It is computed only once for all of them, as this is the most
+ * expensive check for wide tuples.
+ */
+template <typename T>
+inline constexpr bool all_gettable_v =
+    []<std::size_t... Is>(std::index_sequence<Is...>) {
+        return (... && HasGet<Is, T>);
+    }(std::make_index_sequence<std::tuple_size_v<std::remove_cv_t<T>>>{});
+
 /**
  * Satisfied if:
  * - `T` is TupleLike and not protected by `protect_arg()`, and
  * - `std::get<i>(t)` is valid for all indices `0 ≤ i < std::tuple_size_v<T>`.
  */
 template <typename T>
-concept Gettable =
-    TupleLike<T> && !Protected<T> &&
-    []<std::size_t... Is>(std::index_sequence<Is...>) {
-        return (... && HasGet<Is, T>);
-    }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<T>>>{});
+concept Gettable = TupleLike<T> && !Protected<T> &&
+                   all_gettable_v<std::remove_reference_t<T>>;
 
 template <typename... Args>
 concept NoneGettable = (... && !Gettable<Args>);
 
+/** Satisfied if `C` is a character type, possibly cv-qualified. */
+template <typename C>
+concept Character =
+    std::same_as<std::remove_cv_t<C>, char> ||
+    std::same_as<std::remove_cv_t<C>, wchar_t> ||
+    std::same_as<std::remove_cv_t<C>, char8_t> ||
+    std::same_as<std::remove_cv_t<C>, char16_t> ||
+    std::same_as<std::remove_cv_t<C>, char32_t>;
+
+/**
+ * Satisfied if `T` is a range of characters, such as a string literal,
+ * a `std::string` or a `std::string_view`, which is a single value rather
+ * than a sequence of arguments.
+ */
+template <typename T>
+concept CharacterRange = std::ranges::range<T> &&
+                         Character<std::ranges::range_value_t<T>>;
+
+/**
+ * Satisfied if `T` is a contiguous sized range, other than a string, not
+ * marked by `broadcast_arg()`, which `invoke_forall_into` zips with the other
+ * ones.
+ */
+template <typename T>
+concept Zippable = std::ranges::contiguous_range<T> &&
+                   std::ranges::sized_range<T> && !CharacterRange<T> &&
+                   !Protected<T> && !Broadcast<T>;
+
+/**
+ * Satisfied if `F` is a callable marked as safe to invoke concurrently, i.e.
+ * one that has the `is_concurrency_safe_tag` member type.
+ */
+template <typename F>
+concept ConcurrencySafe =
+    requires { typename std::remove_cvref_t<F>::is_concurrency_safe_tag; };
+
+/**
+ * Satisfied if `F` is either:
+ * - a ConcurrencySafe callable, or
+ * - Gettable and all its elements are ConcurrencySafe callables.
+ */
+template <typename F>
+concept ConcurrencySafeCallables =
+    ConcurrencySafe<F> ||
+    (Gettable<F> &&
+     []<std::size_t... Is>(std::index_sequence<Is...>) {
+         return (... && ConcurrencySafe<
+                            std::tuple_element_t<Is, std::remove_cvref_t<F>>>);
+     }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<F>>>{}));
+
+/**
+ * Satisfied if `E` can be given tasks to run, i.e. if it is invocable with
+ * a `std::move_only_function<void()>`.
+ */
+template <typename E>
+concept Executor = std::is_invocable_v<E&, std::move_only_function<void()>>;
+
 template <typename... Args>
 concept NonEmpty = sizeof...(Args) > 0;
 
+/** Satisfied if the types `Ts` have a common type. */
+template <typename... Ts>
+concept HaveCommonType = requires { typename std::common_type_t<Ts...>; };
+
 /**
  * Returns the arity of the first Gettable argument,
  * or `0` if none are found.
@@ -116,23 +229,49 @@ concept HaveArity = (... && HasArity<A, Args>);
 template <typename... Args>
 concept SameArity = HaveArity<first_arity_or_zero<Args...>(), Args...>;
 
+/**
+ * Satisfied if `T` is a non-Gettable rvalue reference, which is copied for
+ * every invoke but the last one, where it is moved.
+ */
+template <typename T>
+concept MovedOnLastInvoke =
+    !Gettable<T> && !Protected<T> && std::is_rvalue_reference_v<T&&>;
+
 /**
  * Tries to forward the given value `t`.
  *
  * If `t` is an non-Gettable rvalue reference (`T&&`), then it is moved only
- * during the last invoke, i.e. when `A == I + 1`.
+ * during the last invoke, i.e. when `Last` is true, and copied otherwise.
+ *
+ * This depends on whether the invoke is the last one rather than on its
+ * index, so that it is instantiated twice per argument instead of `m` times.
  */
-template <std::size_t A, std::size_t I, typename T>
+template <bool Last, typename T>
 constexpr decltype(auto) forward_copy_rvalue(T&& t)
 {
-    if constexpr (A != I + 1 && !Gettable<T> && !Protected<T> &&
-                  std::is_rvalue_reference_v<T&&>) {
+    if constexpr (!Last && MovedOnLastInvoke<T>) {
         return std::remove_cvref_t<T>(t);
     } else {
         return std::forward<T>(t);
     }
 }
 
+/**
+ * Forwards the given value `t` without copying it.
+ *
+ * If `t` is an non-Gettable rvalue reference (`T&&`), then it is passed as
+ * a const lvalue to all invokes but the last one, where it is moved.
+ */
+template <std::size_t A, std::size_t I, typename T>
+constexpr decltype(auto) forward_share_rvalue(T&& t)
+{
+    if constexpr (A != I + 1 && MovedOnLastInvoke<T>) {
+        return std::as_const(t);
+    } else {
+        return std::forward<T>(t);
+    }
+}
+
 /**
  * Returns the appropriate value based on `T`:
  * - if `T` is Gettable, returns the `I`-th element of `t`
@@ -152,6 +291,21 @@ constexpr decltype(auto) try_get(T&& t)
     }
 }
 
+/**
+ * Equivalent to `std::invoke(f, args...)`, but calls function objects and
+ * pointers directly, without instantiating the `std::invoke` machinery for
+ * every invoke.
+ */
+template <typename F, typename... Args>
+constexpr decltype(auto) invoke_one(F&& f, Args&&...args)
+{
+    if constexpr (std::is_member_pointer_v<std::remove_cvref_t<F>>) {
+        return std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+    } else {
+        return std::forward<F>(f)(std::forward<Args>(args)...);
+    }
+}
+
 /**
  * Performs the `I`-th `std::invoke(x1, ..., xn)` with:
  * - `xi = std::get<I>(argi)` if `argi` is Gettable, or
@@ -163,15 +317,17 @@ constexpr decltype(auto) try_get(T&& t)
 template <std::size_t I, typename... Args>
 constexpr decltype(auto) invoke_at(Args&&...args)
 {
-    auto call_invoke = [&]() -> decltype(auto) {
-        return std::invoke(try_get<I>(std::forward<Args>(args))...);
-    };
-
-    if constexpr (std::is_void_v<decltype(call_invoke())>) {
-        call_invoke();
+    // Only Gettable arguments depend on `I`, so for the others the same
+    // `try_get<0>` is used by every invoke.
+    if constexpr (std::is_void_v<decltype(invoke_one(
+                      try_get<Gettable<Args> ? I : 0>(
+                          std::forward<Args>(args))...))>) {
+        invoke_one(try_get<Gettable<Args> ? I : 0>(
+            std::forward<Args>(args))...);
         return std::monostate{};
     } else {
-        return call_invoke();
+        return invoke_one(try_get<Gettable<Args> ? I : 0>(
+            std::forward<Args>(args))...);
     }
 }
 
@@ -182,9 +338,96 @@ constexpr decltype(auto) invoke_at(Args&&...args)
 template <std::size_t A, std::size_t I, typename... Args>
 constexpr decltype(auto) invoke_at_wrapper(Args&&...args)
 {
-    return invoke_at<I>(forward_copy_rvalue<A, I>(std::forward<Args>(args))...);
+    return invoke_at<I>(
+        forward_copy_rvalue<A == I + 1>(std::forward<Args>(args))...);
 }
 
+/**
+ * Serves as a `invoke_at()` wrapper that forwards its arguments
+ * through `forward_share_rvalue()`.
+ */
+template <std::size_t A, std::size_t I, typename... Args>
+constexpr decltype(auto) invoke_at_shared(Args&&...args)
+{
+    return invoke_at<I>(forward_share_rvalue<A, I>(std::forward<Args>(args))...);
+}
+
+/** The type of the argument `T` in the `I`-th of `A` invokes with sharing. */
+template <std::size_t A, std::size_t I, typename T>
+using shared_arg_t =
+    decltype(try_get<I>(forward_share_rvalue<A, I>(std::declval<T>())));
+
+/** Satisfied if the `I`-th of `A` invokes with sharing is valid. */
+template <std::size_t A, std::size_t I, typename... Args>
+concept InvocableSharedAt = std::is_invocable_v<shared_arg_t<A, I, Args>...>;
+
+/**
+ * Satisfied if all `A` invokes accept the non-Gettable rvalue arguments as
+ * const lvalues, i.e. the callable takes them by const reference or by value.
+ */
+template <std::size_t A, typename... Args>
+concept SharesRvalues = []<std::size_t... Is>(std::index_sequence<Is...>) {
+    return (... && InvocableSharedAt<A, Is, Args...>);
+}(std::make_index_sequence<A>{});
+
+/** The type of the result of the `I`-th of `A` invokes. */
+template <std::size_t A, std::size_t I, typename... Args>
+using invoke_result_at_t =
+    decltype(invoke_at_wrapper<A, I>(std::declval<Args>()...));
+
+/** List of types, which keeps a computed pack of types to be reused. */
+template <typename... Ts>
+struct type_list {};
+
+template <std::size_t I, typename T>
+struct indexed_type {
+    using type = T;
+};
+
+template <typename Indices, typename... Ts>
+struct type_indexer;
+
+template <std::size_t... Is, typename... Ts>
+struct type_indexer<std::index_sequence<Is...>, Ts...>
+    : indexed_type<Is, Ts>... {};
+
+/** Selects the base of a `type_indexer` with the given index. */
+template <std::size_t I, typename T>
+indexed_type<I, T> select_indexed(const indexed_type<I, T>&);
+
+/**
+ * The `I`-th type of a `type_list`.
+ *
+ * Unlike `std::tuple_element`, whose recursive implementation instantiates
+ * `O(n)` templates for each index, this takes one overload resolution.
+ */
+template <std::size_t I, typename List>
+struct type_list_element;
+
+template <std::size_t I, typename... Ts>
+struct type_list_element<I, type_list<Ts...>>
+    : decltype(select_indexed<I>(
+          type_indexer<std::index_sequence_for<Ts...>, Ts...>{})) {};
+
+template <std::size_t I, typename List>
+using type_list_element_t = typename type_list_element<I, List>::type;
+
+template <typename Indices, typename... Args>
+struct invoke_results;
+
+/**
+ * The types of the results of all invokes with indices `Is`. Each of them is
+ * computed only once, here, however many places use them.
+ */
+template <std::size_t... Is, typename... Args>
+struct invoke_results<std::index_sequence<Is...>, Args...> {
+    using type = type_list<invoke_result_at_t<sizeof...(Is), Is, Args...>...>;
+};
+
+template <std::size_t A, typename... Args>
+using invoke_results_t =
+    typename invoke_results<std::make_index_sequence<A>, Args...>::type;
+
 /**
  * Custom container that holds lvalue references and satisfies
  * `std::ranges::random_access_range`.
@@ -331,48 +574,442 @@ constexpr T& get(const detail::ref_range<T, N>& range) noexcept
 namespace detail
 {
 
+template <std::size_t I>
+using index_constant = std::integral_constant<std::size_t, I>;
+
+template <typename List>
+struct results_type;
+
 /**
- * Sequentially does `m` invoke calls, where `m` is the common arity of all
- * Gettable arguments.
+ * The type of the object returned by `invoke_forall` for invokes resulting
+ * in types `Rs`, and the types of its elements.
  *
- * If each call results in the same return type, returns a container that
+ * If each call results in the same return type, it is a container that
  * satisfies the `std::ranges::random_access_range` concept.
  */
+template <typename... Rs>
+struct results_type<type_list<Rs...>> {
+    using first_result_type = type_list_element_t<0, type_list<Rs...>>;
+    using base_type = std::remove_reference_t<first_result_type>;
+
+    static constexpr bool same_types =
+        (... && std::same_as<first_result_type, Rs>);
+
+    template <typename R>
+    using element_t = std::conditional_t<
+        std::is_lvalue_reference_v<R>,
+        R,
+        std::conditional_t<same_types, std::remove_reference_t<R>,
+                           std::remove_cvref_t<R>>>;
+
+    using elements = type_list<element_t<Rs>...>;
+
+    using type = std::conditional_t<
+        same_types,
+        std::conditional_t<std::is_lvalue_reference_v<first_result_type>,
+                           ref_range<base_type, sizeof...(Rs)>,
+                           std::array<base_type, sizeof...(Rs)>>,
+        std::tuple<element_t<Rs>...>>;
+};
+
+template <typename List>
+using results_t = typename results_type<List>::type;
+
+/**
+ * Collects the results of `m` invokes, whose types are `Rs`, into an object
+ * of type `results_t<type_list<Rs...>>`. The `I`-th result is obtained, in
+ * order, by calling `result(index_constant<I>{})`.
+ */
+template <typename... Rs, std::size_t... Is, typename Result>
+constexpr results_t<type_list<Rs...>>
+collect_results(type_list<Rs...>, std::index_sequence<Is...>, Result&& result)
+{
+    return results_t<type_list<Rs...>>{ result(index_constant<Is>{})... };
+}
+
+/**
+ * Sequentially does `m` invoke calls, where `m` is the common arity of all
+ * Gettable arguments, and collects their results.
+ */
 template <std::size_t... Is, typename... Args>
-constexpr decltype(auto) invoke_for_all_indices(std::index_sequence<Is...>,
+constexpr decltype(auto) invoke_for_all_indices(std::index_sequence<Is...>
+                                                    indices,
                                                 Args&&...args)
 {
     constexpr size_t arity = sizeof...(Is);
 
-    using first_result_type =
-        decltype(invoke_at_wrapper<arity, 0>(std::forward<Args>(args)...));
+    return collect_results(
+        invoke_results_t<arity, Args...>{}, indices,
+        [&](auto index) -> decltype(auto) {
+            return invoke_at_wrapper<arity, decltype(index)::value>(
+                std::forward<Args>(args)...);
+        });
+}
 
-    if constexpr ((... && std::same_as<first_result_type,
-                                       decltype(invoke_at_wrapper<arity, Is>(
-                                           std::forward<Args>(args)...))>)) {
-        if constexpr (std::is_lvalue_reference_v<first_result_type>) {
-            using base_type = std::remove_reference_t<first_result_type>;
+/**
+ * Like `invoke_for_all_indices()`, but without copying non-Gettable rvalue
+ * arguments.
+ */
+template <std::size_t... Is, typename... Args>
+constexpr decltype(auto)
+invoke_for_all_indices_shared(std::index_sequence<Is...> indices,
+                              Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
 
-            return ref_range<base_type, arity>{
-                invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)... 
-            };
+    using result_types = type_list<decltype(invoke_at_shared<arity, Is>(
+        std::forward<Args>(args)...))...>;
+
+    return collect_results(
+        result_types{}, indices, [&](auto index) -> decltype(auto) {
+            return invoke_at_shared<arity, decltype(index)::value>(
+                std::forward<Args>(args)...);
+        });
+}
+
+/**
+ * Converts results of types `Rs` to their common type, if they differ and
+ * have one; `type` is void otherwise.
+ */
+template <typename List>
+struct common_result {
+    using type = void;
+};
+
+template <typename... Rs>
+requires (!results_type<type_list<Rs...>>::same_types) &&
+         HaveCommonType<Rs...>
+struct common_result<type_list<Rs...>> {
+    using type = std::common_type_t<Rs...>;
+};
+
+/**
+ * Like `invoke_for_all_indices()`, but if the results of the invokes differ
+ * in type and have a common type, converts them all to that type and returns
+ * them in a `std::array`.
+ */
+template <std::size_t... Is, typename... Args>
+constexpr decltype(auto)
+invoke_for_all_indices_common(std::index_sequence<Is...> indices,
+                              Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+
+    using common_type =
+        typename common_result<invoke_results_t<arity, Args...>>::type;
+
+    if constexpr (std::is_void_v<common_type>) {
+        return invoke_for_all_indices(indices, std::forward<Args>(args)...);
+    } else {
+        return std::array<common_type, arity>{
+            static_cast<common_type>(
+                invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...))...
+        };
+    }
+}
+
+/**
+ * How the `I`-th result of type `R` is stored until all invokes are done:
+ * lvalue references as pointers, everything else as a value.
+ */
+template <typename R>
+using stored_result_t = std::conditional_t<std::is_lvalue_reference_v<R>,
+                                           std::remove_reference_t<R>*,
+                                           std::remove_cvref_t<R>>;
+
+template <typename List>
+struct stored_results;
+
+/** Storage for results of types `Rs` until all invokes are done. */
+template <typename... Rs>
+struct stored_results<type_list<Rs...>> {
+    using type = std::tuple<std::optional<stored_result_t<Rs>>...>;
+};
+
+template <typename List>
+using stored_results_t = typename stored_results<List>::type;
+
+/**
+ * The type of the future of an invoke resulting in type `R`. Results are
+ * always stored as values, as a reference could point into the arguments
+ * owned by the task, which are destroyed with it.
+ */
+template <typename R>
+using future_t = std::future<std::remove_cvref_t<R>>;
+
+template <typename List>
+struct futures;
+
+template <typename... Rs>
+struct futures<type_list<Rs...>> {
+    using type = type_list<future_t<Rs>...>;
+};
+
+template <typename List>
+using futures_t = typename futures<List>::type;
+
+/**
+ * Copies (or moves) `args` into a state that can be shared by tasks, which
+ * passes them to the invokes as const lvalues.
+ */
+template <typename... Args>
+auto share_args(Args&&...args)
+{
+    return std::make_shared<const std::tuple<std::decay_t<Args>...>>(
+        std::forward<Args>(args)...);
+}
+
+/**
+ * Gives the `I`-th invoke with the arguments stored at `shared` to
+ * `executor` and returns the future of its result.
+ */
+template <std::size_t I, typename R, typename E, typename Shared>
+future_t<R> launch_at(E& executor, const Shared& shared)
+{
+    std::packaged_task<std::remove_cvref_t<R>()> task([shared] {
+        return std::apply(
+            [](const auto&...args) -> decltype(auto) {
+                return invoke_at<I>(args...);
+            },
+            *shared);
+    });
+    future_t<R> future = task.get_future();
+
+    executor(std::move_only_function<void()>(std::move(task)));
+    return future;
+}
+
+/**
+ * Gives the `m` invokes to `executor` and collects the futures of their
+ * results the same way as `invoke_for_all_indices()` collects the results.
+ *
+ * The arguments are copied once into a state shared by all tasks, which
+ * keep it alive.
+ */
+template <typename E, std::size_t... Is, typename... Args>
+auto invoke_for_all_indices_async(E& executor,
+                                  std::index_sequence<Is...> indices,
+                                  Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+
+    using result_types =
+        invoke_results_t<arity, const std::decay_t<Args>&...>;
+
+    const auto shared = share_args(std::forward<Args>(args)...);
+
+    return collect_results(
+        futures_t<result_types>{}, indices, [&](auto index) {
+            constexpr size_t I = decltype(index)::value;
+
+            return launch_at<I, type_list_element_t<I, result_types>>(
+                executor, shared);
+        });
+}
+
+template <typename Indices, typename... Args>
+class lazy_results;
+
+/**
+ * Tuple-like view of the results of `invoke_forall(args...)`, where `Is` are
+ * the indices of the invokes. Each invoke is done on the first access to its
+ * result, which is then memoized, so the view is not thread-safe.
+ *
+ * The view stores rvalue arguments and references to lvalue ones. Since the
+ * invokes may be done in any order, non-Gettable rvalue arguments are copied
+ * by every invoke but the last one done, which moves from them.
+ */
+template <std::size_t... Is, typename... Args>
+class lazy_results<std::index_sequence<Is...>, Args...> {
+public:
+    static constexpr size_t arity = sizeof...(Is);
+
+private:
+    using result_types = invoke_results_t<arity, Args...>;
+
+public:
+    template <std::size_t I>
+    using element_type = type_list_element_t<
+        I, typename results_type<result_types>::elements>;
+
+    template <typename... Ts>
+    explicit constexpr lazy_results(Ts&&...args)
+        : args_(std::forward<Ts>(args)...) {}
+
+    template <std::size_t I>
+    constexpr element_type<I>& get() &
+    {
+        return result<I>();
+    }
+
+    template <std::size_t I>
+    constexpr const element_type<I>& get() const&
+    {
+        return result<I>();
+    }
+
+    /** Like `std::get` of an rvalue tuple, lets the `I`-th result be moved. */
+    template <std::size_t I>
+    constexpr element_type<I>&& get() &&
+    {
+        return static_cast<element_type<I>&&>(result<I>());
+    }
+
+private:
+    template <std::size_t I>
+    using result_type = type_list_element_t<I, result_types>;
+
+    mutable std::tuple<Args...> args_;
+    mutable stored_results_t<result_types> results_;
+    mutable std::size_t remaining_ = arity;
+
+    /** Does the `I`-th invoke with the stored arguments. */
+    template <std::size_t I, bool Last>
+    constexpr decltype(auto) invoke() const
+    {
+        return [this]<std::size_t... Js>(std::index_sequence<Js...>)
+                   -> decltype(auto) {
+            return invoke_at<I>(forward_copy_rvalue<Last>(
+                std::forward<Args>(std::get<Js>(args_)))...);
+        }(std::index_sequence_for<Args...>{});
+    }
+
+    /** Stores the result of the `I`-th invoke. */
+    template <std::size_t I, bool Last>
+    constexpr void store() const
+    {
+        if constexpr (std::is_lvalue_reference_v<result_type<I>>) {
+            std::get<I>(results_).emplace(&invoke<I, Last>());
+        } else {
+            std::get<I>(results_).emplace(invoke<I, Last>());
+        }
+    }
+
+    /** Returns the `I`-th result, doing the invoke if it was not done yet. */
+    template <std::size_t I>
+    constexpr element_type<I>& result() const
+    {
+        auto& result = std::get<I>(results_);
+
+        if (!result) {
+            // The count drops only once the invoke succeeds, so that after
+            // a throwing invoke the arguments are still not moved from.
+            if (remaining_ == 1) {
+                store<I, true>();
+            } else {
+                store<I, false>();
+            }
+            --remaining_;
+        }
+
+        if constexpr (std::is_lvalue_reference_v<result_type<I>>) {
+            return **result;
         } else {
-            return std::array<std::remove_reference_t<first_result_type>, arity>{
-                invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)...
+            return *result;
+        }
+    }
+};
+
+/**
+ * Source of the `i`-th arguments of runtime-length invokes taken from
+ * a zipped range with elements at `data`. Elements of rvalue ranges are
+ * moved, as each of them is used once.
+ */
+template <typename Pointer, bool Move>
+struct zipped_source {
+    Pointer data;
+
+    constexpr decltype(auto) operator[](std::size_t i) const
+    {
+        if constexpr (Move) {
+            return std::move(data[i]);
+        } else {
+            return data[i];
+        }
+    }
+};
+
+/** Source of an argument that is broadcast to all runtime-length invokes. */
+template <typename T>
+struct broadcast_source {
+    T* value;
+
+    constexpr T& operator[](std::size_t) const
+    {
+        return *value;
+    }
+};
+
+/**
+ * Returns the source of the arguments of runtime-length invokes based on `T`:
+ * - if `T` is Zippable, its elements are passed to the invokes in turn,
+ * - otherwise `t` (or the value it protects or marks) is passed to every
+ *   invoke, as a const lvalue if it is an rvalue, since it is shared by all
+ *   of them.
+ */
+template <typename T>
+constexpr auto make_source(T&& t)
+{
+    if constexpr (Protected<T> || Broadcast<T>) {
+        using value_type = decltype(std::remove_cvref_t<T>::value);
+
+        if constexpr (std::is_lvalue_reference_v<value_type>) {
+            return broadcast_source<std::remove_reference_t<value_type>>{
+                &t.value
             };
+        } else {
+            return broadcast_source<const value_type>{ &t.value };
         }
-    } else {
-        return std::tuple<std::conditional_t<
-            std::is_lvalue_reference_v<
-                decltype(invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...))
-            >,
-            decltype(invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)),
-            std::remove_cvref_t<
-                decltype(invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...))
-            >
-        >...>{
-            invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)...
+    } else if constexpr (Zippable<T>) {
+        return zipped_source<decltype(std::ranges::data(t)),
+                             std::is_rvalue_reference_v<T&&>>{
+            std::ranges::data(t)
         };
+    } else if constexpr (std::is_lvalue_reference_v<T&&>) {
+        return broadcast_source<std::remove_reference_t<T>>{ &t };
+    } else {
+        return broadcast_source<const std::remove_reference_t<T>>{ &t };
+    }
+}
+
+/**
+ * Returns the common length `n` of all Zippable arguments `args`.
+ * Throws `std::invalid_argument` if their lengths differ from each other or
+ * from the length of `out`.
+ */
+template <typename Out, typename... Args>
+constexpr std::size_t zipped_length(const Out& out, const Args&...args)
+{
+    const std::size_t n = std::ranges::size(out);
+
+    auto has_length_n = [n]<typename T>(const T& t) {
+        if constexpr (Zippable<T>) {
+            return std::ranges::size(t) == n;
+        } else {
+            return true;
+        }
+    };
+
+    if (!(... && has_length_n(args))) {
+        throw std::invalid_argument("invoke_forall_into: ranges of different "
+                                    "lengths");
+    }
+
+    return n;
+}
+
+/**
+ * Does the invokes with indices from `first` to `last` (exclusive), writing
+ * their results to `out[first]`, ..., `out[last - 1]`.
+ *
+ * This simple loop is what the compiler vectorizes when it can.
+ */
+template <typename Out, typename... Sources>
+constexpr void invoke_range(Out out, const std::size_t first,
+                            const std::size_t last, const Sources&...sources)
+{
+    for (std::size_t i = first; i < last; ++i) {
+        out[i] = std::invoke(sources[i]...);
     }
 }
 
@@ -397,11 +1034,153 @@ constexpr decltype(auto) invoke_forall(Args&&...args)
     }
 }
 
+/**
+ * Works like `invoke_forall()`, except that results of different types which
+ * have a common type are all converted to it, so that they are returned in
+ * a `std::array`.
+ */
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr decltype(auto) invoke_forall_common(Args&&...args)
+{
+    if constexpr (NoneGettable<Args...>) {
+        return invoke_at<0>(std::forward<Args>(args)...);
+    } else {
+        constexpr size_t arity = first_arity_or_zero<Args...>();
+
+        return invoke_for_all_indices_common(
+            std::make_index_sequence<arity>{}, std::forward<Args>(args)...);
+    }
+}
+
+/**
+ * Works like `invoke_forall()`, but never copies non-Gettable rvalue
+ * arguments: every invoke but the last one gets them as const lvalues, and
+ * the last one gets them as rvalues. It is checked at compile time that the
+ * callable accepts them this way, i.e. it takes them by const reference or
+ * by value (in which case each invoke makes its own copy, as before).
+ */
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...> &&
+         SharesRvalues<first_arity_or_zero<Args...>(), Args...>
+constexpr decltype(auto) invoke_forall_shared(Args&&...args)
+{
+    if constexpr (NoneGettable<Args...>) {
+        return invoke_at<0>(std::forward<Args>(args)...);
+    } else {
+        constexpr size_t arity = first_arity_or_zero<Args...>();
+
+        return invoke_for_all_indices_shared(
+            std::make_index_sequence<arity>{}, std::forward<Args>(args)...);
+    }
+}
+
+/**
+ * Works like `invoke_forall()`, but if there are Gettable arguments, returns
+ * a `lazy_results` view that does each invoke only on the first `get` of its
+ * result. The view has the same `std::tuple_size` and `std::tuple_element`
+ * as the result of `invoke_forall()`.
+ */
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr decltype(auto) invoke_forall_lazy(Args&&...args)
+{
+    if constexpr (NoneGettable<Args...>) {
+        return invoke_at<0>(std::forward<Args>(args)...);
+    } else {
+        constexpr size_t arity = first_arity_or_zero<Args...>();
+
+        return lazy_results<std::make_index_sequence<arity>, Args...>{
+            std::forward<Args>(args)...
+        };
+    }
+}
+
+/**
+ * Works like `invoke_forall(f, args...)`, but does not wait for the invokes.
+ * Each of them is given as a task to `executor`, and the futures of their
+ * results are returned in place of the results (a single future if no
+ * argument is Gettable). The callable `f` (or, if it is Gettable, each of its
+ * elements) must be marked as concurrency safe.
+ *
+ * The arguments are copied (or moved) once, as by `std::async`, and shared by
+ * all the tasks; use `std::ref` to pass a reference. The results are stored
+ * in the futures as values.
+ */
+template <typename E, typename F, typename... Args>
+requires Executor<E> && ConcurrencySafeCallables<F> && SameArity<F, Args...>
+auto invoke_forall_async(E&& executor, F&& f, Args&&...args)
+{
+    if constexpr (NoneGettable<F, Args...>) {
+        using result_type = type_list_element_t<
+            0, invoke_results_t<1, const std::decay_t<F>&,
+                                const std::decay_t<Args>&...>>;
+
+        return launch_at<0, result_type>(
+            executor,
+            share_args(std::forward<F>(f), std::forward<Args>(args)...));
+    } else {
+        constexpr size_t arity = first_arity_or_zero<F, Args...>();
+
+        return invoke_for_all_indices_async(executor,
+                                            std::make_index_sequence<arity>{},
+                                            std::forward<F>(f),
+                                            std::forward<Args>(args)...);
+    }
+}
+
+/**
+ * Satisfied if `Out` is a sized random access range to which the results of
+ * `invoke_forall_into` can be written.
+ */
+template <typename Out>
+concept OutputRange = std::ranges::random_access_range<Out> &&
+                      std::ranges::sized_range<Out>;
+
+/** Satisfied if at least one argument is Zippable. */
+template <typename... Args>
+concept AnyZippable = (... || Zippable<Args>);
+
+/**
+ * Runtime-length counterpart of `invoke_forall`: for `i = 0, ..., n - 1`
+ * writes to `out[i]` the result of `std::invoke` whose arguments are the
+ * `i`-th elements of the Zippable arguments (contiguous sized ranges, such
+ * as `std::vector`, `std::span` or `std::array`) and the other arguments as
+ * they are. Ranges of characters, such as strings, are not zipped, but
+ * passed whole like scalars. All Zippable arguments and `out` must have the
+ * same length `n`, otherwise `std::invalid_argument` is thrown before any
+ * invoke.
+ *
+ * A range is passed whole to every invoke if it is marked by
+ * `broadcast_arg()`. Shared rvalue arguments are never copied, but passed as
+ * const lvalues.
+ */
+template <typename Out, typename... Args>
+requires OutputRange<Out> && NonEmpty<Args...> && AnyZippable<Args...>
+constexpr void invoke_forall_into(Out&& out, Args&&...args)
+{
+    const std::size_t n = zipped_length(out, args...);
+
+    invoke_range(std::ranges::begin(out), 0, n,
+                 make_source(std::forward<Args>(args))...);
+}
+
+/**
+ * Marks the callable `f` as safe to invoke concurrently, so that it can be
+ * passed to `invoke_forall_par` (declared in invoke_forall_par.h).
+ * Only its `const` call operator is used.
+ */
+template <typename F>
+constexpr auto concurrency_safe(F&& f)
+{
+    return concurrency_safe_callable<std::decay_t<F>>{ std::forward<F>(f) };
+}
+
 /**
  * Makes `invoke_forall` treat protected Gettable argument `arg` as a regular
  * argument.
  *
- * If given argument is non-Gettable, does nothing and returns `arg` as it is.
+ * If given argument is not Gettable, does nothing and returns `arg` as it is.
  */
 template <typename T> 
 constexpr decltype(auto) protect_arg(T&& arg)
@@ -413,18 +1192,116 @@ constexpr decltype(auto) protect_arg(T&& arg)
     }
 }
 
+/**
+ * Makes `invoke_forall_into` pass Zippable argument `arg` whole to every
+ * invoke instead of zipping it with the other ones.
+ *
+ * If given argument is not Zippable, does nothing and returns `arg` as it is.
+ */
+template <typename T>
+constexpr decltype(auto) broadcast_arg(T&& arg)
+{
+    if constexpr (Zippable<T>) {
+        return broadcasted_arg<T>{ std::forward<T>(arg) };
+    } else {
+        return std::forward<T>(arg);
+    }
+}
+
 } /* namespace detail */
 
+/**
+ * `std` injection that makes `lazy_results` Gettable, with the same arity and
+ * element types as the results it views.
+ */
+namespace std
+{
+
+template <typename Indices, typename... Args>
+struct tuple_size<detail::lazy_results<Indices, Args...>>
+    : integral_constant<size_t,
+                        detail::lazy_results<Indices, Args...>::arity> {};
+
+template <size_t I, typename Indices, typename... Args>
+struct tuple_element<I, detail::lazy_results<Indices, Args...>> {
+    using type = typename detail::lazy_results<Indices, Args...>::
+        template element_type<I>;
+};
+
+template <size_t I, typename Indices, typename... Args>
+constexpr decltype(auto) get(detail::lazy_results<Indices, Args...>& results)
+{
+    return results.template get<I>();
+}
+
+template <size_t I, typename Indices, typename... Args>
+constexpr decltype(auto)
+get(const detail::lazy_results<Indices, Args...>& results)
+{
+    return results.template get<I>();
+}
+
+template <size_t I, typename Indices, typename... Args>
+constexpr decltype(auto) get(detail::lazy_results<Indices, Args...>&& results)
+{
+    return std::move(results).template get<I>();
+}
+
+} /* namespace std */
+
 template <typename... Args>
 constexpr decltype(auto) invoke_forall(Args&&...args)
 {
     return detail::invoke_forall(std::forward<Args>(args)...);
 }
 
+template <typename... Args>
+constexpr decltype(auto) invoke_forall_common(Args&&...args)
+{
+    return detail::invoke_forall_common(std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+constexpr decltype(auto) invoke_forall_shared(Args&&...args)
+{
+    return detail::invoke_forall_shared(std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+constexpr decltype(auto) invoke_forall_lazy(Args&&...args)
+{
+    return detail::invoke_forall_lazy(std::forward<Args>(args)...);
+}
+
+template <typename E, typename... Args>
+auto invoke_forall_async(E&& executor, Args&&...args)
+{
+    return detail::invoke_forall_async(std::forward<E>(executor),
+                                       std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+constexpr void invoke_forall_into(Args&&...args)
+{
+    detail::invoke_forall_into(std::forward<Args>(args)...);
+}
+
+template <typename F>
+constexpr auto concurrency_safe(F&& f)
+{
+    return detail::concurrency_safe(std::forward<F>(f));
+}
+
 template <typename T> 
 constexpr decltype(auto) protect_arg(T&& arg)
 {
     return detail::protect_arg(std::forward<T>(arg));
 }
 
+template <typename T>
+constexpr decltype(auto) broadcast_arg(T&& arg)
+{
+    return detail::broadcast_arg(std::forward<T>(arg));
+}
+
 #endif /* INVOKE_FORALL_H */
@@ -0,0 +1,89 @@
+// Compile-time benchmark of `invoke_forall`: compiles invoke_forall_wide.cpp
+// for tuples of several arities and reports the time and peak memory that
+// the compiler needed.
+//
+// Usage: ./invoke_forall_benchmark [compiler [flags...]]
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr std::size_t ARITIES[] = {64, 128, 192, 256};
+    constexpr std::size_t INSTANTIATIONS = 8;
+    constexpr const char *SOURCE = "invoke_forall_wide.cpp";
+
+    struct measurement {
+        double seconds;
+        long peak_kilobytes;
+    };
+
+    // Runs `command` and measures it; exits if it fails.
+    measurement run(const std::vector<std::string> &command) {
+        std::vector<char *> argv;
+        for (const std::string &arg : command)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        const auto start = clock_type::now();
+        const pid_t pid = fork();
+
+        if (pid < 0) {
+            std::cerr << "fork failed\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if (pid == 0) {
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status;
+        rusage usage;
+        wait4(pid, &status, 0, &usage);
+        const std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "compilation failed:";
+            for (const std::string &arg : command)
+                std::cerr << ' ' << arg;
+            std::cerr << '\n';
+            std::exit(EXIT_FAILURE);
+        }
+
+        return {elapsed.count(), usage.ru_maxrss};
+    }
+} // anonymous namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> compiler = {"clang++", "-std=c++23", "-O2"};
+    if (argc > 1)
+        compiler.assign(argv + 1, argv + argc);
+
+    std::cout << std::setw(8) << "arity" << std::setw(16) << "instantiations"
+              << std::setw(12) << "time [s]" << std::setw(16)
+              << "peak mem [KB]" << '\n';
+
+    for (const std::size_t arity : ARITIES) {
+        std::vector<std::string> command = compiler;
+        command.insert(command.end(),
+                       {"-DINVOKE_FORALL_ARITY=" + std::to_string(arity),
+                        "-DINVOKE_FORALL_INSTANTIATIONS="
+                            + std::to_string(INSTANTIATIONS),
+                        "-c", SOURCE, "-o", "/dev/null"});
+
+        const measurement m = run(command);
+        std::cout << std::setw(8) << arity << std::setw(16) << INSTANTIATIONS
+                  << std::setw(12) << std::fixed << std::setprecision(2)
+                  << m.seconds << std::setw(16) << m.peak_kilobytes << '\n';
+    }
+}
@@ -1,9 +1,14 @@
 #include "invoke_forall.h"
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace {
     int sum1(const std::array<int, 3> &t) {
@@ -71,6 +76,114 @@ int main() {
               << get<0>(res4) << " " << get<1>(res4) << " " << get<2>(res4)
               << '\n';
 
+    // heterogeneous results converted to their common type
+    auto res5 = invoke_forall_common([](auto a){ return a * 2; },
+                                     std::tuple{1, 2.5, 3L});
+    static_assert(std::same_as<decltype(res5), std::array<double, 3>>);
+    // It writes out "res5 = 6 5 2\n".
+    std::ranges::sort(res5, std::greater{});
+    std::cout << "res5 =";
+    for (auto const &x : res5)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // rvalue arguments shared by all invokes instead of copied
+    auto count = [](const std::vector<int> &v, int x) {
+        return std::ranges::count(v, x);
+    };
+    auto res6 = invoke_forall_shared(count, std::vector{1, 2, 2, 3, 3, 3},
+                                     std::array{1, 2, 3});
+    // It writes out "res6 = 1 2 3\n".
+    std::cout << "res6 =";
+    for (auto const &x : res6)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // results computed only when accessed
+    int calls = 0;
+    auto res7 = invoke_forall_lazy([&calls](auto a){ calls++; return a; }, T1);
+    // It writes out "res7 = abc 2.5 after 2 calls\n".
+    std::cout << "res7 = " << get<2>(res7) << ' ' << get<1>(res7);
+    std::cout << " after " << calls << " calls\n";
+
+    // a lazy invoke that threw is done again on the next access, and the
+    // rvalue vector is still moved only into the last invoke
+    bool fail = true;
+    auto sized = [&fail](int i, std::vector<int> v) {
+        if (i == 2 && std::exchange(fail, false))
+            throw std::runtime_error("not yet");
+        return v.size() * 10 + i;
+    };
+    auto res7b = invoke_forall_lazy(sized, std::array{1, 2, 3},
+                                    std::vector{0, 0, 0});
+    std::cout << "res7b = " << get<0>(res7b);
+    try {
+        std::cout << ' ' << get<1>(res7b);
+    } catch (const std::runtime_error &) {
+        std::cout << "(retried)";
+    }
+    // It writes out "res7b = 31 (retried) 32 33\n".
+    std::cout << ' ' << get<1>(res7b) << ' ' << get<2>(res7b) << '\n';
+
+    // a lazy result destructured like a tuple
+    auto [res7c0, res7c1, res7c2] =
+        invoke_forall_lazy([](int a){ return a * a; }, std::array{1, 2, 3});
+    // It writes out "res7c = 1 4 9\n".
+    std::cout << "res7c = " << res7c0 << ' ' << res7c1 << ' ' << res7c2
+              << '\n';
+
+    // runtime-length ranges zipped, with scalars broadcast
+    std::vector<int> V = {1, 2, 3, 4};
+    std::vector<long> res8(V.size());
+    invoke_forall_into(res8, [](int v, int w, long d){ return v * w + d; },
+                       V, V, 100L);
+    // It writes out "res8 = 101 104 109 116\n".
+    std::cout << "res8 =";
+    for (auto const &x : res8)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // a range marked by broadcast_arg passed whole to every invoke
+    invoke_forall_into(res8, [](int v, const std::vector<int> &all){
+        return v * static_cast<long>(all.size());
+    }, V, broadcast_arg(V));
+    // It writes out "res8 = 4 8 12 16\n".
+    std::cout << "res8 =";
+    for (auto const &x : res8)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // strings passed whole to every invoke, like scalars
+    std::string suffix = "!";
+    std::vector<std::string> res8s(V.size());
+    invoke_forall_into(res8s, [](int v, const char *s, const std::string &t){
+        return std::to_string(v) + s + t;
+    }, V, "ab", suffix);
+    // It writes out "res8s = 1ab! 2ab! 3ab! 4ab!\n".
+    std::cout << "res8s =";
+    for (auto const &x : res8s)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // invokes given as tasks to an executor, results returned as futures
+    auto square = concurrency_safe([](const std::string &s, int n) {
+        std::string res;
+        for (int i = 0; i < n; i++)
+            res += s;
+        return res;
+    });
+    std::vector<std::thread> threads;
+    auto spawn = [&threads](auto task){ threads.emplace_back(std::move(task)); };
+    auto res9 = invoke_forall_async(spawn, square, std::string("ab"),
+                                    std::array{1, 2, 3});
+    // It writes out "res9 = ab abab ababab\n".
+    std::cout << "res9 =";
+    for (auto &x : res9)
+        std::cout << ' ' << x.get();
+    std::cout << '\n';
+    for (auto &thread : threads)
+        thread.join();
+
     // It writes out "sum1 = 6\n".
     std::cout << "sum1 = "
               << invoke_forall(sum1, protect_arg(std::array{1, 2, 3}))
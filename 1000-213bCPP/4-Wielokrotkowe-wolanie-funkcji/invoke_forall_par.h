@@ -0,0 +1,187 @@
+/**
+ * Parallel counterparts of `invoke_forall` and `invoke_forall_into`.
+ *
+ * They use the standard parallel algorithms, which may need an external
+ * backend (e.g. TBB for libstdc++), so they are kept out of `invoke_forall.h`
+ * and only programs including this header have to link against it.
+ */
+
+#ifndef INVOKE_FORALL_PAR_H
+#define INVOKE_FORALL_PAR_H
+
+#include "invoke_forall.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <execution>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail
+{
+
+/** Satisfied if `T` is a standard execution policy. */
+template <typename T>
+concept ExecutionPolicy = std::is_execution_policy_v<std::remove_cvref_t<T>>;
+
+/** Number of invokes that `invoke_forall_into` does in one parallel task. */
+inline constexpr std::size_t RANGE_CHUNK_SIZE = 1 << 12;
+
+/** Does the `I`-th invoke by calling `store`. */
+template <std::size_t I, typename Store>
+void store_at(Store& store)
+{
+    store(index_constant<I>{});
+}
+
+/**
+ * Does the `m` invoke calls concurrently according to `policy`, then collects
+ * their results the same way as `invoke_for_all_indices()`.
+ *
+ * Non-Gettable rvalue arguments are copied by all invokes but the last one,
+ * which moves from them, so if there are any, the last invoke is done only
+ * after all the others.
+ */
+template <typename Policy, std::size_t... Is, typename... Args>
+decltype(auto) invoke_for_all_indices_par(Policy&& policy,
+                                          std::index_sequence<Is...> indices,
+                                          Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+    constexpr size_t concurrent =
+        (... || MovedOnLastInvoke<Args>) ? arity - 1 : arity;
+
+    using result_types = invoke_results_t<arity, Args...>;
+
+    stored_results_t<result_types> results;
+
+    auto store = [&](auto index) {
+        constexpr size_t I = decltype(index)::value;
+
+        if constexpr (std::is_lvalue_reference_v<
+                          type_list_element_t<I, result_types>>) {
+            std::get<I>(results).emplace(
+                &invoke_at_wrapper<arity, I>(std::forward<Args>(args)...));
+        } else {
+            std::get<I>(results).emplace(
+                invoke_at_wrapper<arity, I>(std::forward<Args>(args)...));
+        }
+    };
+
+    // The `i`-th invoke is found in constant time, whatever `m` is.
+    static constexpr std::array<void (*)(decltype(store)&), arity> stores{
+        &store_at<Is, decltype(store)>...
+    };
+
+    const std::array<std::size_t, arity> runtime_indices{ Is... };
+
+    std::for_each(std::forward<Policy>(policy), runtime_indices.begin(),
+                  runtime_indices.begin() + concurrent,
+                  [&store](const std::size_t i) { stores[i](store); });
+
+    if constexpr (concurrent < arity) {
+        store(index_constant<arity - 1>{});
+    }
+
+    return collect_results(
+        result_types{}, indices, [&](auto index) -> decltype(auto) {
+            constexpr size_t I = decltype(index)::value;
+
+            if constexpr (std::is_lvalue_reference_v<
+                              type_list_element_t<I, result_types>>) {
+                return **std::get<I>(results);
+            } else {
+                return std::move(*std::get<I>(results));
+            }
+        });
+}
+
+/**
+ * Works like `invoke_forall(f, args...)`, but does the invokes concurrently
+ * according to the execution `policy`. The callable `f` (or, if it is
+ * Gettable, each of its elements) must be marked as concurrency safe.
+ *
+ * A non-Gettable rvalue argument, including `f` itself (e.g. a temporary
+ * returned by `concurrency_safe()`), is copied by all invokes but the last
+ * one, which moves from it. The last invoke is then done only after all the
+ * others, so pass such arguments as lvalues to do all invokes concurrently.
+ *
+ * The results must be move constructible. As with the standard parallel
+ * algorithms, `std::terminate` is called if an invoke throws.
+ */
+template <typename Policy, typename F, typename... Args>
+requires ExecutionPolicy<Policy> && ConcurrencySafeCallables<F> &&
+         SameArity<F, Args...>
+decltype(auto) invoke_forall_par(Policy&& policy, F&& f, Args&&...args)
+{
+    if constexpr (NoneGettable<F, Args...>) {
+        return invoke_at<0>(std::forward<F>(f), std::forward<Args>(args)...);
+    } else {
+        constexpr size_t arity = first_arity_or_zero<F, Args...>();
+
+        return invoke_for_all_indices_par(std::forward<Policy>(policy),
+                                          std::make_index_sequence<arity>{},
+                                          std::forward<F>(f),
+                                          std::forward<Args>(args)...);
+    }
+}
+
+/**
+ * Works like `invoke_forall_into(out, f, args...)`, but splits the invokes
+ * into chunks of `RANGE_CHUNK_SIZE` done concurrently according to the
+ * execution `policy`. As for `invoke_forall_par`, the callable `f` must be
+ * marked as concurrency safe.
+ */
+template <typename Policy, typename Out, typename F, typename... Args>
+requires ExecutionPolicy<Policy> && OutputRange<Out> &&
+         ConcurrencySafeCallables<F> && AnyZippable<F, Args...>
+void invoke_forall_into(Policy&& policy, Out&& out, F&& f, Args&&...args)
+{
+    const std::size_t n = zipped_length(out, f, args...);
+
+    std::vector<std::size_t> chunks;
+    chunks.reserve(n / RANGE_CHUNK_SIZE + 1);
+
+    for (std::size_t first = 0; first < n; first += RANGE_CHUNK_SIZE) {
+        chunks.push_back(first);
+    }
+
+    const auto all_sources =
+        std::tuple{ make_source(std::forward<F>(f)),
+                    make_source(std::forward<Args>(args))... };
+
+    std::for_each(std::forward<Policy>(policy), chunks.begin(), chunks.end(),
+                  [&](const std::size_t first) {
+                      const std::size_t last =
+                          std::min(first + RANGE_CHUNK_SIZE, n);
+
+                      std::apply(
+                          [&](const auto&...sources) {
+                              invoke_range(std::ranges::begin(out), first,
+                                           last, sources...);
+                          },
+                          all_sources);
+                  });
+}
+
+} /* namespace detail */
+
+template <typename Policy, typename... Args>
+decltype(auto) invoke_forall_par(Policy&& policy, Args&&...args)
+{
+    return detail::invoke_forall_par(std::forward<Policy>(policy),
+                                     std::forward<Args>(args)...);
+}
+
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy>
+void invoke_forall_into(Policy&& policy, Args&&...args)
+{
+    detail::invoke_forall_into(std::forward<Policy>(policy),
+                               std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_PAR_H */
@@ -0,0 +1,34 @@
+#include "invoke_forall_par.h"
+#include <array>
+#include <execution>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main() {
+    // independent invokes done concurrently
+    auto square = concurrency_safe([](const std::string &s, int n) {
+        std::string res;
+        for (int i = 0; i < n; i++)
+            res += s;
+        return res;
+    });
+    auto res1 = invoke_forall_par(std::execution::par, square,
+                                  std::string("ab"), std::array{1, 2, 3});
+    // It writes out "res1 = ab abab ababab\n".
+    std::cout << "res1 =";
+    for (auto const &x : res1)
+        std::cout << ' ' << x;
+    std::cout << '\n';
+
+    // runtime-length ranges zipped in chunks done concurrently
+    std::vector<int> V(10000);
+    for (int i = 0; i < static_cast<int>(V.size()); i++)
+        V[i] = i;
+    std::vector<long> res2(V.size());
+    auto scale = concurrency_safe([](int v, long d){ return v * d; });
+    invoke_forall_into(std::execution::par, res2, scale, V, 3L);
+    // It writes out "res2 = 0 3 29997\n".
+    std::cout << "res2 = " << res2[0] << ' ' << res2[1] << ' ' << res2.back()
+              << '\n';
+}
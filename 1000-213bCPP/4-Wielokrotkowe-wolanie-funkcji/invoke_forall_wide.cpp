@@ -0,0 +1,92 @@
+// Instantiations of `invoke_forall` on wide tuples, compiled (but never run)
+// by invoke_forall_benchmark to measure the cost of the metaprogramming.
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#ifndef INVOKE_FORALL_ARITY
+#define INVOKE_FORALL_ARITY 64
+#endif
+
+#ifndef INVOKE_FORALL_INSTANTIATIONS
+#define INVOKE_FORALL_INSTANTIATIONS 8
+#endif
+
+namespace {
+    constexpr std::size_t arity = INVOKE_FORALL_ARITY;
+
+    template <std::size_t I>
+    using index = std::integral_constant<std::size_t, I>;
+
+    // Tuple-like type of `arity` elements of different types, whose `get`
+    // (unlike that of `std::tuple`) takes constant time to compile, so that
+    // only the cost of `invoke_forall` itself is measured.
+    struct indices_type {};
+
+    constexpr indices_type indices;
+} // anonymous namespace
+
+namespace std {
+    template <>
+    struct tuple_size<indices_type> : integral_constant<size_t, arity> {};
+
+    template <size_t I>
+    struct tuple_element<I, indices_type> {
+        using type = index<I>;
+    };
+
+    template <size_t I>
+    constexpr index<I> get(const indices_type &) noexcept {
+        return {};
+    }
+} // namespace std
+
+// Included after `std::get` for `indices_type`, so that it is found.
+#include "invoke_forall.h"
+
+namespace {
+
+    // The same result type for every element: `invoke_forall` returns arrays.
+    template <std::size_t K>
+    struct add {
+        template <typename T>
+        constexpr std::size_t operator()(T, std::size_t x) const {
+            return T::value + x + K;
+        }
+    };
+
+    // A different result type for every element: `invoke_forall` returns
+    // tuples.
+    template <std::size_t K>
+    struct shift {
+        template <typename T>
+        constexpr auto operator()(T) const {
+            return index<T::value + K>{};
+        }
+    };
+
+    template <std::size_t K>
+    constexpr bool instantiate() {
+        constexpr auto sums = invoke_forall(add<K>{}, indices, K);
+        static_assert(sums[arity - 1] == arity - 1 + 2 * K);
+
+        constexpr auto shifted = invoke_forall(shift<K>{}, indices);
+        static_assert(std::get<arity - 1>(shifted) == arity - 1 + K);
+
+        std::array<std::size_t, arity> values{};
+        auto refs = invoke_forall(
+            [](std::size_t &x) -> std::size_t & { return x; }, values);
+        refs[0] = K;
+
+        return values[0] == K;
+    }
+
+    template <std::size_t... Ks>
+    constexpr bool instantiate_all(std::index_sequence<Ks...>) {
+        return (... && instantiate<Ks>());
+    }
+
+    static_assert(instantiate_all(
+        std::make_index_sequence<INVOKE_FORALL_INSTANTIATIONS>{}));
+} // anonymous namespace
@@ -1,54 +1,333 @@
 #ifndef PLAYLIST_H
 #define PLAYLIST_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
-#include <list>
+#include <limits>
 #include <map>
 #include <memory>
-#include <set>
+#include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 namespace cxx {
 
-    template <typename T, typename P>
+    /**
+     * Reference counting policy of `playlist` which uses atomic counters,
+     * so that copies of a playlist may be used by different threads.
+     */
+    struct atomic_refcount {
+        using counter_t = std::atomic<std::size_t>;
+
+        static void increment(counter_t &count) noexcept {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Returns whether the last reference was dropped.
+        static bool decrement(counter_t &count) noexcept {
+            return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
+        static std::size_t load(const counter_t &count) noexcept {
+            return count.load(std::memory_order_acquire);
+        }
+    };
+
+    /**
+     * Reference counting policy of `playlist` which uses plain counters,
+     * for playlists whose copies are all used by a single thread.
+     */
+    struct local_refcount {
+        using counter_t = std::size_t;
+
+        static void increment(counter_t &count) noexcept {
+            ++count;
+        }
+
+        /// Returns whether the last reference was dropped.
+        static bool decrement(counter_t &count) noexcept {
+            return --count == 0;
+        }
+
+        static std::size_t load(const counter_t &count) noexcept {
+            return count;
+        }
+    };
+
+    template <typename T, typename P, typename RefCount = atomic_refcount>
     class playlist {
         // In the following time complexities n denotes
-        // the number of records stored in the playlist.
+        // the number of records stored in the playlist
+        // and t the number of distinct tracks.
 
         private:
+            /**
+             * Pointer to a `V` shared by all copies of the pointer, which
+             * count the references in the node of the `V` with `RefCount`.
+             */
+            template <typename V>
+            class counted_ptr {
+                public:
+                    counted_ptr() noexcept = default;
+
+                    counted_ptr(std::nullptr_t) noexcept {}
+
+                    counted_ptr(const counted_ptr &other) noexcept
+                        : node(other.node) {
+                        if (node) {
+                            RefCount::increment(node->count);
+                        }
+                    }
+
+                    counted_ptr(counted_ptr &&other) noexcept
+                        : node(std::exchange(other.node, nullptr)) {}
+
+                    ~counted_ptr() noexcept {
+                        if (node && RefCount::decrement(node->count)) {
+                            std::allocator<node_t> allocator;
+                            std::destroy_at(node);
+                            allocator.deallocate(node, 1);
+                        }
+                    }
+
+                    counted_ptr & operator=(counted_ptr other) noexcept {
+                        std::swap(node, other.node);
+                        return *this;
+                    }
+
+                    /**
+                     * Creates a `V` from `args` in a single allocation
+                     * with its counter, like `std::make_shared`.
+                     *
+                     * Time complexity: `O(1)` plus the constructor of `V`
+                     */
+                    template <typename... Args>
+                    static counted_ptr make(Args &&...args) {
+                        std::allocator<node_t> allocator;
+                        counted_ptr ptr;
+                        node_t *node = allocator.allocate(1);
+
+                        try {
+                            std::construct_at(node,
+                                              std::forward<Args>(args)...);
+                        }
+                        catch (...) {
+                            allocator.deallocate(node, 1);
+
+                            throw;
+                        }
+
+                        ptr.node = node;
+                        return ptr;
+                    }
+
+                    V & operator*() const noexcept {
+                        return node->value;
+                    }
+
+                    V * operator->() const noexcept {
+                        return &node->value;
+                    }
+
+                    V * get() const noexcept {
+                        return node ? &node->value : nullptr;
+                    }
+
+                    explicit operator bool() const noexcept {
+                        return node != nullptr;
+                    }
+
+                    /// Returns whether this is the only reference.
+                    bool unique() const noexcept {
+                        return node && RefCount::load(node->count) == 1;
+                    }
+
+                private:
+                    struct node_t {
+                        typename RefCount::counter_t count{1};
+                        V value;
+
+                        template <typename... Args>
+                        explicit node_t(Args &&...args)
+                            : value(std::forward<Args>(args)...) {}
+                    };
+
+                    node_t *node = nullptr;
+            };
+
             struct playlist_impl {
-                // Forward declare the struct to avoid
-                // circular dependencies relating to iterator types.
-                struct Entry;
+                // Records and tracks are identified by their indices
+                // in the flat arrays below, which keeps them small
+                // and allocated in bulk.
+                using index_t = std::uint32_t;
 
-                using play_tracks_t = std::list<Entry>;
-                using play_iter_t = typename play_tracks_t::iterator;
+                static constexpr index_t NONE =
+                    std::numeric_limits<index_t>::max();
 
                 /**
-                 * Defines the '<' operator for the `play_tracks_t::iterator`
-                 * type which allows to store iterators in a `std::set`.
-                 * 
-                 * Iterators are compared by their memory addresses.
+                 * Array kept in fixed-size chunks, so that adding an element
+                 * never moves the others. Copies of the array share their
+                 * chunks until one of them modifies a chunk, which copies
+                 * only that chunk.
+                 *
+                 * A chunk to whose element a reference was given is pinned:
+                 * it is not shared, and copies of the array copy it.
                  */
-                struct IterCmp {
-                    bool operator()(const play_iter_t &lhs,
-                                    const play_iter_t &rhs) const {
-                        return &(*lhs) < &(*rhs);
-                    }
+                template <typename V>
+                class chunked_array {
+                    public:
+                        static constexpr std::size_t CHUNK_SIZE = 256;
+
+                        const V & operator[](index_t i) const noexcept {
+                            const chunk_t &chunk = *chunks[i / CHUNK_SIZE];
+                            return chunk.items[i % CHUNK_SIZE];
+                        }
+
+                        /**
+                         * Returns a modifiable reference to the `i`-th
+                         * element, first copying its chunk if it is shared.
+                         *
+                         * Time complexity: `O(1)`,
+                         * `O(CHUNK_SIZE)` if copied
+                         */
+                        V & touch(index_t i) {
+                            auto &chunk = chunks[i / CHUNK_SIZE];
+
+                            if (!chunk.unique()) {
+                                chunk = copy_of(*chunk);
+                            }
+
+                            return chunk->items[i % CHUNK_SIZE];
+                        }
+
+                        /**
+                         * Returns a modifiable reference to the `i`-th
+                         * element, which must have been `touch()`ed.
+                         *
+                         * Time complexity: `O(1)`
+                         */
+                        V & touched(index_t i) noexcept {
+                            chunk_t &chunk = *chunks[i / CHUNK_SIZE];
+                            return chunk.items[i % CHUNK_SIZE];
+                        }
+
+                        /**
+                         * Copies all shared chunks.
+                         *
+                         * Time complexity: `O(capacity())`
+                         */
+                        void unshare() {
+                            for (auto &chunk : chunks) {
+                                if (!chunk.unique()) {
+                                    chunk = copy_of(*chunk);
+                                }
+                            }
+                        }
+
+                        /**
+                         * Pins the chunk of the `i`-th element,
+                         * which must have been `touch()`ed.
+                         *
+                         * Time complexity: amortized `O(1)`
+                         */
+                        void pin(index_t i) {
+                            chunk_t &chunk = *chunks[i / CHUNK_SIZE];
+
+                            if (!chunk.pinned) {
+                                pinned.push_back(i / CHUNK_SIZE);
+                                chunk.pinned = true;
+                            }
+                        }
+
+                        /**
+                         * Unpins all chunks, once the
+                         * references to their elements are invalid.
+                         *
+                         * Time complexity: `O(number of pinned chunks)`
+                         */
+                        void unpin_all() noexcept {
+                            for (index_t c : pinned) {
+                                chunks[c]->pinned = false;
+                            }
+
+                            pinned.clear();
+                        }
+
+                        /**
+                         * Replaces the pinned chunks, which this array shares
+                         * with the one it was copied from, with their copies.
+                         *
+                         * Time complexity: `O(CHUNK_SIZE)` per pinned chunk
+                         */
+                        void unshare_pinned() {
+                            for (index_t c : pinned) {
+                                chunks[c] = copy_of(*chunks[c]);
+                            }
+
+                            pinned.clear();
+                        }
+
+                        bool has_pinned() const noexcept {
+                            return !pinned.empty();
+                        }
+
+                        std::size_t capacity() const noexcept {
+                            return chunks.size() * CHUNK_SIZE;
+                        }
+
+                        /**
+                         * Makes room for the chunks of `n` elements, so that
+                         * growing up to them does not move the others.
+                         *
+                         * Time complexity: `O(n / CHUNK_SIZE)`
+                         */
+                        void reserve(std::size_t n) {
+                            chunks.reserve((n + CHUNK_SIZE - 1) / CHUNK_SIZE);
+                        }
+
+                        /**
+                         * Adds a chunk of default-constructed elements.
+                         *
+                         * Time complexity: amortized `O(CHUNK_SIZE)`
+                         */
+                        void grow() {
+                            chunks.push_back(counted_ptr<chunk_t>::make());
+                        }
+
+                        void clear() noexcept {
+                            chunks.clear();
+                            pinned.clear();
+                        }
+
+                    private:
+                        struct chunk_t {
+                            std::array<V, CHUNK_SIZE> items;
+                            bool pinned = false;
+                        };
+
+                        std::vector<counted_ptr<chunk_t>> chunks;
+                        std::vector<index_t> pinned;
+
+                        static counted_ptr<chunk_t>
+                        copy_of(const chunk_t &chunk) {
+                            return counted_ptr<chunk_t>::make(chunk.items);
+                        }
                 };
 
-                using iter_set_t = std::set<play_iter_t, IterCmp>;
-
                 /**
                  * Defines the transparent comparator for the
-                 * `std::map<T, iter_set_t>` which enables heterogeneous lookup.
+                 * `std::map<const T*, index_t>` which compares the tracks
+                 * pointed to and enables heterogeneous lookup.
                  */
                 struct TrackCmp {
                     using is_transparent = void;
 
-                    bool operator()(const T &lhs, const T &rhs) const {
-                        return lhs < rhs;
+                    bool operator()(const T *lhs, const T *rhs) const {
+                        return *lhs < *rhs;
                     }
 
                     bool operator()(const T *lhs, const T &rhs) const {
@@ -60,76 +339,614 @@ namespace cxx {
                     }
                 };
 
-                using sorted_tracks_t = std::map<const T, iter_set_t, TrackCmp>;
+                // Maps each track to its dense id in `tracks`. Tracks are
+                // kept outside of the map, so copying it never copies them.
+                using sorted_tracks_t =
+                    std::map<const T *, index_t, TrackCmp>;
                 using sorted_iter_t = typename sorted_tracks_t::const_iterator;
 
-                // Define the struct now that all iterator types are known.
-                // For each set of params we keep:
-                // - an iterator to the <K, V> pair where the track is stored
-                // - an iterator to the V element (iterator to this Entry)
+                /**
+                 * A slot of the record array. A used slot keeps the params
+                 * of a record and intrusive links of two lists: the play
+                 * order and the records of the same track (in play order).
+                 * A free slot has no params and `next` links it to the
+                 * next free slot.
+                 */
                 struct Entry {
-                    P params;
-                    typename sorted_tracks_t::iterator map_iter;
-                    typename iter_set_t::iterator set_iter;
+                    std::optional<P> params;
+                    index_t track = NONE;
+                    index_t prev = NONE;
+                    index_t next = NONE;
+                    index_t next_occurrence = NONE;
                 };
 
-                play_tracks_t play_tracks;
-                sorted_tracks_t sorted_tracks;
+                /**
+                 * For each track we keep the track itself, an iterator to
+                 * its node in `sorted_tracks`, its number of records, and
+                 * the first and the last of them. A free id has no records
+                 * and `first` links it to the next free id.
+                 */
+                struct Track {
+                    counted_ptr<const T> track;
+                    sorted_iter_t sorted_iter;
+                    std::size_t count = 0;
+                    index_t first = NONE;
+                    index_t last = NONE;
+                };
+
+                chunked_array<Entry> entries;
+                index_t used = 0;
+                index_t free_entry = NONE;
+
+                index_t play_first = NONE;
+                index_t play_last = NONE;
+                std::size_t size = 0;
+
+                chunked_array<Track> tracks;
+                index_t tracks_used = 0;
+                index_t free_track = NONE;
 
-                bool shareable = true;
+                // Shared by copies until the set of tracks of one
+                // of them changes.
+                counted_ptr<sorted_tracks_t> sorted_tracks =
+                    counted_ptr<sorted_tracks_t>::make();
 
                 playlist_impl() = default;
+                playlist_impl(const playlist_impl &other) = default;
                 ~playlist_impl() noexcept = default;
+
+                /**
+                 * Returns the map of tracks, first copying
+                 * it (and all tracks) if it is shared.
+                 *
+                 * Time complexity: `O(1)`, `O(t)` if copied
+                 */
+                sorted_tracks_t & touch_sorted_tracks() {
+                    if (!sorted_tracks.unique()) {
+                        tracks.unshare();
+
+                        auto copy = counted_ptr<sorted_tracks_t>::make(
+                            *sorted_tracks);
+
+                        // Nothing throws from here on.
+                        for (auto it = copy->cbegin(); it != copy->cend();
+                             ++it) {
+                            tracks.touched(it->second).sorted_iter = it;
+                        }
+
+                        sorted_tracks = std::move(copy);
+                    }
+
+                    return *sorted_tracks;
+                }
+
+                /**
+                 * Returns the map of tracks if it is shared, and null
+                 * otherwise. A shared map is replaced with its copy by
+                 * `touch_sorted_tracks()`, but `sorted_iterator`s still point
+                 * to it, so a failed modification restores it.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                counted_ptr<sorted_tracks_t> shared_sorted_tracks() const
+                noexcept {
+                    if (sorted_tracks.unique()) {
+                        return nullptr;
+                    }
+
+                    return sorted_tracks;
+                }
+
+                /**
+                 * Reinstalls the map of tracks returned by
+                 * `shared_sorted_tracks()`, if it has been replaced with its
+                 * copy, after a failed modification rolled back the tracks
+                 * to those of the map. All tracks must have been `touch()`ed.
+                 *
+                 * Time complexity: `O(1)`, `O(t)` if reinstalled
+                 */
+                void restore_sorted_tracks(
+                    counted_ptr<sorted_tracks_t> original) noexcept {
+                    if (!original || original.get() == sorted_tracks.get()) {
+                        return;
+                    }
+
+                    for (auto it = original->cbegin(); it != original->cend();
+                         ++it) {
+                        tracks.touched(it->second).sorted_iter = it;
+                    }
+
+                    sorted_tracks = std::move(original);
+                }
+
+                /**
+                 * Stores `params` in a free slot and returns its index.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: amortized `O(1)`
+                 */
+                index_t acquire_entry(P const &params) {
+                    if (free_entry != NONE) {
+                        Entry &e = entries.touch(free_entry);
+                        e.params.emplace(params);
+
+                        index_t i = free_entry;
+                        free_entry = e.next;
+                        return i;
+                    }
+
+                    if (used == NONE) {
+                        throw std::length_error("push_back, playlist full");
+                    }
+
+                    if (used == entries.capacity()) {
+                        entries.grow();
+                    }
+
+                    entries.touch(used).params.emplace(params);
+                    return used++;
+                }
+
+                /**
+                 * Destroys the params of the `i`-th record
+                 * and makes its slot free.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                void release_entry(index_t i) noexcept {
+                    Entry &e = entries.touched(i);
+                    e.params.reset();
+                    e.next = free_entry;
+                    free_entry = i;
+                }
+
+                /**
+                 * Returns a free track id, making room for a new one if
+                 * there is none. The id stays free until it is used.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: amortized `O(1)`
+                 */
+                index_t free_track_id() {
+                    if (free_track != NONE) {
+                        return free_track;
+                    }
+
+                    if (tracks_used == NONE) {
+                        throw std::length_error("push_back, playlist full");
+                    }
+
+                    if (tracks_used == tracks.capacity()) {
+                        tracks.grow();
+                    }
+
+                    free_track = tracks_used++;
+                    return free_track;
+                }
+
+                /**
+                 * Gives the id returned by `free_track_id()`, which must
+                 * have been `touch()`ed, to `track` stored at `sorted_iter`.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                void use_track_id(counted_ptr<const T> track,
+                                  sorted_iter_t sorted_iter) noexcept {
+                    Track &t = tracks.touched(free_track);
+                    free_track = t.first;
+                    t = {std::move(track), sorted_iter, 0, NONE, NONE};
+                }
+
+                /**
+                 * Removes the track with the given id, whose records are
+                 * already gone, and frees the id. The track and the map
+                 * must have been `touch()`ed.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                void release_track(index_t id) noexcept {
+                    Track &t = tracks.touched(id);
+                    sorted_tracks->erase(t.sorted_iter);
+                    t = {nullptr, {}, 0, free_track, NONE};
+                    free_track = id;
+                }
+
+                /**
+                 * Appends the `i`-th record, of the track with the given
+                 * id, to both of its lists. The record, the track, and the
+                 * last records of both lists must have been `touch()`ed.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                void link_entry(index_t i, index_t id) noexcept {
+                    Entry &e = entries.touched(i);
+                    e.track = id;
+                    e.prev = play_last;
+                    e.next = NONE;
+                    e.next_occurrence = NONE;
+
+                    if (play_last == NONE) {
+                        play_first = i;
+                    }
+                    else {
+                        entries.touched(play_last).next = i;
+                    }
+                    play_last = i;
+
+                    Track &t = tracks.touched(id);
+                    if (t.last == NONE) {
+                        t.first = i;
+                    }
+                    else {
+                        entries.touched(t.last).next_occurrence = i;
+                    }
+                    t.last = i;
+                    ++t.count;
+                    ++size;
+                }
+
+                /**
+                 * Removes the `i`-th record from the play order. The record
+                 * and its neighbours must have been `touch()`ed.
+                 *
+                 * Time complexity: `O(1)`
+                 */
+                void unlink_entry(index_t i) noexcept {
+                    Entry &e = entries.touched(i);
+
+                    if (e.prev == NONE) {
+                        play_first = e.next;
+                    }
+                    else {
+                        entries.touched(e.prev).next = e.next;
+                    }
+
+                    if (e.next == NONE) {
+                        play_last = e.prev;
+                    }
+                    else {
+                        entries.touched(e.next).prev = e.prev;
+                    }
+
+                    --size;
+                }
+
+                /**
+                 * Touches the `i`-th record and its neighbours.
+                 *
+                 * Time complexity: `O(1)`, `O(CHUNK_SIZE)` if copied
+                 */
+                void touch_with_neighbours(index_t i) {
+                    const Entry &e = entries.touch(i);
+
+                    if (e.prev != NONE) {
+                        entries.touch(e.prev);
+                    }
+
+                    if (e.next != NONE) {
+                        entries.touch(e.next);
+                    }
+                }
+
+                /**
+                 * Stores a new `track` under a free id and returns the id.
+                 * The track has no records yet, so it must get one or be
+                 * released. Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(log t)`,
+                 * `O(t)` more if the map of tracks is shared
+                 */
+                index_t add_track(T const &track) {
+                    // Prepare all that may throw before inserting the track.
+                    auto &sorted = touch_sorted_tracks();
+                    tracks.touch(free_track_id());
+                    auto stored = counted_ptr<const T>::make(track);
+
+                    auto sorted_iter =
+                        sorted.try_emplace(stored.get(), free_track).first;
+
+                    index_t id = free_track;
+                    use_track_id(std::move(stored), sorted_iter);
+                    return id;
+                }
+
+                /**
+                 * Returns the id of `track`, adding it if it is new, with
+                 * the track and its last record `touch()`ed.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(log t)`,
+                 * `O(t)` more if the map of tracks is shared
+                 */
+                index_t touch_track(T const &track) {
+                    auto sorted_iter = sorted_tracks->find(track);
+
+                    if (sorted_iter == sorted_tracks->end()) {
+                        return add_track(track);
+                    }
+
+                    index_t id = sorted_iter->second;
+                    if (tracks[id].last != NONE) {
+                        entries.touch(tracks[id].last);
+                    }
+                    tracks.touch(id);
+
+                    return id;
+                }
+
+                /**
+                 * Adds a new (`track`, `params`) record.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(log n)`,
+                 * `O(t)` more if the map of tracks is shared
+                 */
+                void push_back(T const &track, P const &params) {
+                    // First copy the shared chunks modified below,
+                    // which does not change the playlist.
+                    if (play_last != NONE) {
+                        entries.touch(play_last);
+                    }
+
+                    auto original_sorted_tracks = shared_sorted_tracks();
+                    index_t id = NONE;
+
+                    try {
+                        id = touch_track(track);
+                        link_entry(acquire_entry(params), id);
+                    }
+                    catch (...) {
+                        // Rollback the track addition, if any,
+                        // and the copy of the map of tracks.
+                        if (id != NONE && tracks[id].count == 0) {
+                            release_track(id);
+                        }
+                        restore_sorted_tracks(
+                            std::move(original_sorted_tracks));
+
+                        throw;
+                    }
+                }
+
+                /**
+                 * Adds the (track, params) records of the range
+                 * [`first`, `last`) in order. Records are linked only once
+                 * all of them are stored, so that a failure is rolled back
+                 * by releasing their slots and the new tracks.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(m log t)`, where `m` denotes the
+                 * number of records in the range,
+                 * `O(t)` more if the map of tracks is shared
+                 */
+                template <typename It>
+                void append_range(It first, It last) {
+                    // First copy the shared chunks modified below, and
+                    // allocate what is known in advance, which does not
+                    // change the playlist.
+                    if (play_last != NONE) {
+                        entries.touch(play_last);
+                    }
+
+                    std::size_t count = std::distance(first, last);
+                    entries.reserve(used + count);
+
+                    // The track ids and the slots of the stored records.
+                    std::vector<std::pair<index_t, index_t>> records;
+                    records.reserve(count);
+
+                    auto original_sorted_tracks = shared_sorted_tracks();
+
+                    try {
+                        for (It it = first; it != last; ++it) {
+                            const auto &[track, params] = *it;
+
+                            records.emplace_back(touch_track(track), NONE);
+                            records.back().second = acquire_entry(params);
+                        }
+                    }
+                    catch (...) {
+                        // Release the slots in reverse order to restore the
+                        // free list. A new track is released at its last
+                        // record, after which its id has no track.
+                        for (auto record = records.rbegin();
+                             record != records.rend(); ++record) {
+                            auto [id, entry] = *record;
+
+                            if (entry != NONE) {
+                                release_entry(entry);
+                            }
+
+                            if (tracks[id].count == 0 && tracks[id].track) {
+                                release_track(id);
+                            }
+                        }
+
+                        restore_sorted_tracks(
+                            std::move(original_sorted_tracks));
+
+                        throw;
+                    }
+
+                    // Nothing throws from here on.
+                    for (auto [id, entry] : records) {
+                        link_entry(entry, id);
+                    }
+                }
+
+                /**
+                 * Removes the first record.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(1)`,
+                 * `O(t)` more if the map of tracks is shared
+                 */
+                void pop_front() {
+                    index_t first = play_first;
+                    index_t id = entries[first].track;
+
+                    // First copy the shared chunks modified below,
+                    // which does not change the playlist.
+                    touch_with_neighbours(first);
+                    tracks.touch(id);
+                    if (tracks[id].count == 1) {
+                        touch_sorted_tracks();
+                    }
+
+                    // Records of a track are kept in play order,
+                    // so the first record is also the first of its track.
+                    Track &t = tracks.touched(id);
+                    t.first = entries[first].next_occurrence;
+                    if (t.first == NONE) {
+                        t.last = NONE;
+                    }
+
+                    unlink_entry(first);
+                    release_entry(first);
+
+                    // Don't keep any zombie keys.
+                    if (--t.count == 0) {
+                        release_track(id);
+                    }
+                }
+
+                /**
+                 * Removes all records of the track with the given id.
+                 * Has no effect if an exception is thrown.
+                 *
+                 * Time complexity: `O(k)`, where `k` denotes the number
+                 * of removed records, `O(t)` more if the map is shared
+                 */
+                void remove(index_t id) {
+                    // First copy the shared chunks modified below, which
+                    // does not change the playlist. Records that become
+                    // neighbours of removed ones are neighbours of removed
+                    // ones already.
+                    for (index_t i = tracks[id].first; i != NONE;
+                         i = entries[i].next_occurrence) {
+                        touch_with_neighbours(i);
+                    }
+                    tracks.touch(id);
+                    touch_sorted_tracks();
+
+                    index_t entry = tracks[id].first;
+                    while (entry != NONE) {
+                        index_t next = entries[entry].next_occurrence;
+                        unlink_entry(entry);
+                        release_entry(entry);
+                        entry = next;
+                    }
+
+                    // Erase the track now that all its occurrences are gone.
+                    release_track(id);
+                }
+
+                /**
+                 * Removes all records and tracks.
+                 * The map of tracks must not be shared.
+                 *
+                 * Time complexity: `O(n)`
+                 */
+                void clear() noexcept {
+                    entries.clear();
+                    used = 0;
+                    free_entry = NONE;
+                    play_first = NONE;
+                    play_last = NONE;
+                    size = 0;
+                    tracks.clear();
+                    tracks_used = 0;
+                    free_track = NONE;
+                    sorted_tracks->clear();
+                }
             };
 
-            mutable std::shared_ptr<playlist_impl> data;
+            using index_t = typename playlist_impl::index_t;
+
+            mutable counted_ptr<playlist_impl> data;
 
             /**
              * Initializes `data` if it is null (e.g. after a move operation).
-             * 
+             *
              * Time complexity: `O(1)`
              */
             void check_null_data() const {
                 if (!data) {
-                    data = std::make_shared<playlist_impl>();
+                    data = counted_ptr<playlist_impl>::make();
                 }
             }
 
             /**
-             * Deep-copies shared playlist data.
-             * 
-             * Time complexity: `O(n log n)`
+             * Returns a copy of (non-null) `data`. The copy shares its chunks
+             * and its map of tracks with the original, and the modifications
+             * that follow copy only what they change. Records keep their
+             * indices in the copy.
+             *
+             * Time complexity: `O(n / CHUNK_SIZE + t / CHUNK_SIZE)`,
+             * plus `O(CHUNK_SIZE)` per pinned chunk
+             */
+            counted_ptr<playlist_impl> detached_data() const;
+
+            /**
+             * Detaches shared playlist data, which is then accessed by
+             * a reference.
+             *
+             * Time complexity: `O(1)`, `detached_data()` if copied
              */
-            void copy_on_write(bool shareable = true);
+            void copy_on_write();
+
+            /**
+             * Applies `modification`, which must have no effect if it throws,
+             * to the playlist data, detaching it first if it is shared.
+             * References to params are invalidated if it succeeds, so their
+             * chunks are unpinned.
+             *
+             * Time complexity: `O(1)` plus `modification`,
+             * `detached_data()` if copied
+             */
+            template <typename F>
+            void modify(F modification);
 
         public:
             /**
              * Creates an empty playlist.
-             * 
+             *
              * Time complexity: `O(1)`
              */
-            playlist() : data(std::make_shared<playlist_impl>()) {}
+            playlist() : data(counted_ptr<playlist_impl>::make()) {}
 
+            /**
+             * Creates a playlist of the (track, params) pairs of the range
+             * [`first`, `last`), like `append_range()`.
+             *
+             * Time complexity: `O(m log m)`, where `m` denotes the number
+             * of pairs
+             */
+            template <std::forward_iterator It>
+            playlist(It first, It last) : playlist() {
+                append_range(first, last);
+            }
 
             /**
              * Copy constructor.
-             * 
-             * Deep copies `other` if it is not shareable.
-             * 
-             * Time complexity: `O(1)`, `O(n log n)` if copied
+             *
+             * Detaches the copy if references to params of `other`
+             * have been given.
+             *
+             * Time complexity: `O(1)`, `copy_on_write()` if copied
              */
             playlist(playlist const &other) : data(other.data) {
-                if (data && !data->shareable) {
+                if (data && data->entries.has_pinned()) {
                     copy_on_write();
                 }
             }
 
             /**
              * Move constructor.
-             * 
+             *
              * Leaves the moved-from `other` playlist in a
              * 'valid state' by setting its data to `nullptr`.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             playlist(playlist &&other) noexcept : data(std::move(other.data)) {
@@ -148,23 +965,20 @@ namespace cxx {
             /**
              * Iterator that allows traversal over all
              * records in order of their respective insertions.
-             * 
+             *
              * All methods are `O(1)` and `noexcept`.
              */
-            class play_iterator : private playlist_impl::play_iter_t {
+            class play_iterator {
                 friend class playlist;
-                using Base = typename playlist_impl::play_iter_t;
 
                 public:
                     using iterator_category = std::forward_iterator_tag;
-                    using value_type = Base::value_type;
-                    using difference_type = Base::difference_type;
-                    using reference = Base::reference;
+                    using value_type = typename playlist_impl::Entry;
+                    using difference_type = std::ptrdiff_t;
+                    using reference = const value_type &;
 
                     play_iterator() noexcept = default;
 
-                    play_iterator(const Base &other) noexcept : Base(other) {}
-
                     play_iterator(const play_iterator &other)
                     noexcept = default;
 
@@ -172,51 +986,60 @@ namespace cxx {
                     noexcept = default;
 
                     bool operator==(const play_iterator &other) const noexcept {
-                        return static_cast<const Base&>(*this) ==
-                               static_cast<const Base&>(other);
+                        return impl == other.impl && pos == other.pos;
                     }
 
                     bool operator!=(const play_iterator &other) const noexcept {
-                        return static_cast<const Base&>(*this) !=
-                               static_cast<const Base&>(other);
+                        return !(*this == other);
                     }
 
                     play_iterator & operator++() noexcept {
-                        Base::operator++();
+                        pos = impl->entries[pos].next;
                         return *this;
                     }
 
                     play_iterator operator++(int) noexcept  {
                         play_iterator iter = *this;
-                        Base::operator++();
+                        ++*this;
                         return iter;
                     }
+
+                private:
+                    const playlist_impl *impl = nullptr;
+                    index_t pos = playlist_impl::NONE;
+
+                    play_iterator(const playlist_impl *impl, index_t pos)
+                    noexcept : impl(impl), pos(pos) {}
+
+                    reference entry() const noexcept {
+                        return impl->entries[pos];
+                    }
             };
 
             /**
              * Returns a `play_iterator` to the first entry.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             play_iterator play_begin() const {
                 check_null_data();
-                return { data->play_tracks.begin() };
+                return { data.get(), data->play_first };
             }
 
             /**
              * Returns a `play_iterator` past the last entry.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             play_iterator play_end() const {
                 check_null_data();
-                return { data->play_tracks.end() };
+                return { data.get(), playlist_impl::NONE };
             }
 
             /**
              * Iterator that allows traversal over all
              * tracks in order of their default ordering.
-             * 
+             *
              * All methods are `O(1)` and `noexcept`.
              */
             class sorted_iterator : private playlist_impl::sorted_iter_t {
@@ -231,8 +1054,6 @@ namespace cxx {
 
                     sorted_iterator() noexcept = default;
 
-                    sorted_iterator(const Base &other) noexcept : Base(other) {}
-                    
                     sorted_iterator(const sorted_iterator &other)
                     noexcept = default;
 
@@ -261,290 +1082,261 @@ namespace cxx {
                         Base::operator++();
                         return iter;
                     }
+
+                private:
+                    // Needed to look up the number of occurrences.
+                    const playlist_impl *impl = nullptr;
+
+                    sorted_iterator(const playlist_impl *impl,
+                                    const Base &other) noexcept
+                        : Base(other), impl(impl) {}
             };
 
             /**
              * Returns a `sorted_iterator` to the first entry.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             sorted_iterator sorted_begin() const {
                 check_null_data();
-                return { data->sorted_tracks.begin() };
+                return { data.get(), data->sorted_tracks->begin() };
             }
 
             /**
              * Returns a `sorted_iterator` past the last entry.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             sorted_iterator sorted_end() const {
                 check_null_data();
-                return { data->sorted_tracks.end() };
+                return { data.get(), data->sorted_tracks->end() };
             }
 
             /**
              * Adds a new (`track`, `params`) record to the playlist.
-             * 
-             * Time complexity: `O(log n)`, `O(n log n)` if copied
+             *
+             * Time complexity: `O(log n)`, plus `detached_data()`
+             * and `O(t)` if copied
              */
             void push_back(T const &track, P const &params) {
-                std::weak_ptr<playlist_impl> original_data = data;
-                check_null_data();
-                copy_on_write();
-
-                try {
-                // Try to insert the track into the sorted map.
-                auto [sorted_iter, inserted] =
-                    data->sorted_tracks.try_emplace(track);
-
-                try {
-                    // Append new entry to the play_tracks list.
-                    // We will fix default 'set_iter' in a moment.
-                    auto play_iter = data->play_tracks.insert(play_end(),
-                        { params, sorted_iter, {} }
-                    );
-
-                    try {
-                        // Insert the iterator into the sorted map.
-                        auto res = sorted_iter->second.insert(play_iter);
-
-                        // Store the set iterator back into list entry.
-                        play_iter->set_iter = res.first;
-                    }
-                    catch (...) {
-                        // Rollback play_tracks insertion.
-                        data->play_tracks.erase(play_iter);
-
-                        throw;
-                    }
-                }
-                catch (...) {
-                    // Rollback sorted map insertion (if there was one).
-                    if (inserted) {
-                        data->sorted_tracks.erase(sorted_iter);
-                    }
+                modify([&](playlist_impl &impl) {
+                    impl.push_back(track, params);
+                });
+            }
 
-                    throw;
-                }
+            /**
+             * Adds the (track, params) pairs of the range [`first`, `last`)
+             * to the playlist in order. Either all or none of them are added,
+             * as this has no effect if an exception is thrown.
+             *
+             * Time complexity: `O(m log n)`, where `m` denotes the number
+             * of pairs, plus `detached_data()` and `O(t)` if copied
+             */
+            template <std::forward_iterator It>
+            void append_range(It first, It last) {
+                if (first == last) {
+                    return;
                 }
-                catch (...) {
-                    if (auto p = original_data.lock()) {
-                        data = p;
-                    }
 
-                    throw;
-                }
+                modify([&](playlist_impl &impl) {
+                    impl.append_range(first, last);
+                });
             }
 
             /**
              * Removes the first record from the playlist.
-             * 
+             *
              * Throws `std::out_of_range` if the playlist is empty.
-             * 
-             * Time complexity: `O(1)`, `O(n log n)` if copied
+             *
+             * Time complexity: `O(1)`, plus `detached_data()`
+             * and `O(t)` if copied
              */
             void pop_front() {
-                if (!data || data->play_tracks.empty()) {
+                if (!data || data->size == 0) {
                     throw std::out_of_range("pop_front, playlist empty");
                 }
 
-                copy_on_write();
-
-                // Get the first entry from the play_tracks list.
-                auto &entry = *(data->play_tracks.begin());
-
-                // Remove the entry from the set.
-                // Since we pass an iterator to self, the erase runs in O(1).
-                entry.map_iter->second.erase(entry.set_iter);
-
-                // Don't keep any zombie keys.
-                if (entry.map_iter->second.empty()) {
-                    data->sorted_tracks.erase(entry.map_iter);
-                }
-
-                data->play_tracks.pop_front();
+                modify([](playlist_impl &impl) {
+                    impl.pop_front();
+                });
             }
 
             /**
              * Returns a reference to the first record in the playlist.
-             * 
+             *
              * Throws `std::out_of_range` if the playlist is empty.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             const std::pair<T const &, P const &> front() const {
-                if (!data || data->play_tracks.empty()) {
+                if (!data || data->size == 0) {
                     throw std::out_of_range("front, playlist empty");
                 }
 
-                // Get the first entry from the play_tracks list.
-                auto &entry = *(data->play_tracks.begin());
-
-                return {entry.map_iter->first, entry.params};
+                return play(play_begin());
             }
 
             /**
              * Removes all records with a given `track` from the playlist.
-             * 
+             *
              * Throws `std::invalid_argument` if no such record is found.
-             * 
+             *
              * Time complexity: `O(log n + k)`,
-             * where `k` denotes the number of removed records
+             * where `k` denotes the number of removed records,
+             * plus `detached_data()` and `O(t)` if copied
              */
             void remove(T const &track) {
                 if (!data) {
                     throw std::invalid_argument("remove, unknown track");
                 }
 
-                auto sorted_iter = data->sorted_tracks.find(track);
+                auto sorted_iter = data->sorted_tracks->find(track);
 
-                if (sorted_iter == sorted_end()) {
+                if (sorted_iter == data->sorted_tracks->end()) {
                     throw std::invalid_argument("remove, unknown track");
                 }
 
-                std::weak_ptr<playlist_impl> original_data = data;
-                copy_on_write();
-                
-                try {
-                // Re-find in case copy_on_write() invalidated iterators.
-                sorted_iter = data->sorted_tracks.find(track);
-
-                // Remove all occurrences of the track in play_tracks.
-                for (auto &play_iter : sorted_iter->second) {
-                    data->play_tracks.erase(play_iter);
-                }
-
-                // Erase the track from the sorted map
-                // now that all its occurrences are gone.
-                data->sorted_tracks.erase(sorted_iter);
-                }
-                catch (...) {
-                    if (auto p = original_data.lock()) {
-                        data = p;
-                    }
+                // Ids are kept in copies, so it stays valid.
+                index_t id = sorted_iter->second;
 
-                    throw;
-                }
+                modify([id](playlist_impl &impl) {
+                    impl.remove(id);
+                });
             }
 
             /**
              * Removes all records from the playlist.
-             * 
+             *
              * Time complexity: `O(n)`, `O(1)` if copied
              */
             void clear() noexcept {
                 // We do not call check_null_data() or copy_on_write()
                 // here to avoid initializing/copying data just to destroy it.
+                // The map of tracks may be shared even if data is not.
 
-                if (!data || !data.unique()) {
+                if (!data || !data.unique() ||
+                    !data->sorted_tracks.unique()) {
                     data = nullptr;
                 }
                 else {
-                    data->play_tracks.clear();
-                    data->sorted_tracks.clear();
+                    data->clear();
                 }
             }
 
             /**
              * Returns the number of records in the playlist.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             size_t size() const noexcept {
                 // Since we avoid calling check_null_data()
                 // here, this method can be noexcept.
 
-                return data ? data->play_tracks.size() : 0;
+                return data ? data->size : 0;
             }
 
             /**
              * Returns a reference to the record that `it` points to.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             const std::pair<T const &, P const &>
             play(play_iterator const &it) const {
-                const auto& base_it = static_cast<play_iterator::Base>(it);
-                return {base_it->map_iter->first, base_it->params};
+                const auto &entry = it.entry();
+                return {*it.impl->tracks[entry.track].track, *entry.params};
             }
 
             /**
              * Returns a reference to the track from the record that `it`
              * points to and the number of its occurrences in the playlist.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             const std::pair<T const &, size_t>
             pay(sorted_iterator const &it) const {
                 const auto& base_it = static_cast<sorted_iterator::Base>(it);
-                return {base_it->first, base_it->second.size()};
+                return {*base_it->first,
+                        it.impl->tracks[base_it->second].count};
             }
 
             /**
              * Returns a reference to the params
              * of the record that `it` points to.
-             * 
-             * Time complexity: `O(1)`, `O(n log n)` if copied
+             *
+             * Time complexity: amortized `O(1)`,
+             * plus `detached_data()` if copied
              */
             P & params(play_iterator const &it) {
                 // We assume data is not null if there are any valid iterators.
+                // Records keep their indices in copies,
+                // so `it` points to the same record in a copy.
+                // The copy replaces shared data only once the record is
+                // touched, so iterators stay valid if copying throws.
+                check_null_data();
 
-                const auto& base_it = static_cast<play_iterator::Base>(it);
-
-                if (!data.unique()) {
-                    // Save the position of the original iterator.
-                    auto dist = std::distance(
-                        data->play_tracks.begin(), 
-                        base_it
-                    );
-
-                    copy_on_write(false);
+                counted_ptr<playlist_impl> target =
+                    data.unique() ? data : detached_data();
 
-                    // Now we need a new iterator, since the
-                    // original still points to the previous data.
-                    auto new_it = data->play_tracks.begin();
-                    std::advance(new_it, dist);
+                auto &params = *target->entries.touch(it.pos).params;
 
-                    return new_it->params;
-                }
+                // Disable sharing of the chunk, as the reference may mutate.
+                target->entries.pin(it.pos);
 
-                // At that point, data is guaranteed to be unique.
-                // Simply disable sharing, as the reference may mutate.
-                data->shareable = false;
-
-                return base_it->params;
+                data = std::move(target);
+                return params;
             }
 
             /**
              * Returns a const reference to the params
              * of the record that `it` points to.
-             * 
+             *
              * Time complexity: `O(1)`
              */
             const P & params(play_iterator const &it) const noexcept {
-                const auto& base_it = static_cast<play_iterator::Base>(it);
-                return base_it->params;
+                return *it.entry().params;
             }
         };
 
-        template <typename T, typename P>
-        void playlist<T, P>::copy_on_write(bool shareable) {
+        template <typename T, typename P, typename RefCount>
+        auto playlist<T, P, RefCount>::detached_data() const
+        -> counted_ptr<playlist_impl> {
+            auto copy = counted_ptr<playlist_impl>::make(*data);
+
+            // References may have been given only to params in the
+            // pinned chunks, so only these are not shared.
+            copy->entries.unshare_pinned();
+
+            return copy;
+        }
+
+        template <typename T, typename P, typename RefCount>
+        void playlist<T, P, RefCount>::copy_on_write() {
             check_null_data();
 
             if (!data.unique()) {
-                playlist plist;
+                // Replace current data with the new, unique copy.
+                data = detached_data();
+            }
+        }
 
-                // Copy all tracks into a new playlist instance.
-                for (auto it = play_begin(); it != play_end(); ++it) {
-                    plist.push_back(play(it).first, play(it).second);
-                }
+        template <typename T, typename P, typename RefCount>
+        template <typename F>
+        void playlist<T, P, RefCount>::modify(F modification) {
+            check_null_data();
 
-                // Replace current data with the new, unique copy.
-                data = plist.data;
+            if (data.unique()) {
+                modification(*data);
+            }
+            else {
+                // The original data is replaced only once the modification
+                // succeeds, so its iterators stay valid if it throws.
+                auto copy = detached_data();
+                modification(*copy);
+                data = std::move(copy);
             }
 
-            data->shareable = shareable;
+            // References to params are invalidated by the modification.
+            data->entries.unpin_all();
         }
 
 } /* namespace cxx */
@@ -60,6 +60,18 @@ namespace {
       clog << pl.play(pit);
   }
 
+  // Parametry, których kopiowanie może zgłosić wyjątek.
+  struct fragile_t {
+    bool fail;
+
+    fragile_t(bool fail) : fail(fail) {}
+
+    fragile_t(fragile_t const &other) : fail(other.fail) {
+      if (fail)
+        throw std::runtime_error("fragile_t");
+    }
+  };
+
   // Plejlistę można też odtwarzać w inny sposób.
   template<typename T, typename P>
   void lay(playlist<T, P> &pl) {
@@ -181,4 +193,55 @@ int main() {
   assert(playlist2.size() == BIG_VALUE);
   for (unsigned i = 0; i < 10 * BIG_VALUE; i++)
     vec.push_back(playlist2); // Wszystkie obiekty w vec współdzielą dane.
+
+  // Kopie plejlisty używane w jednym wątku mogą liczyć referencje
+  // bez operacji atomowych.
+  playlist<string_view, params_t, cxx::local_refcount> playlist3;
+  for (unsigned i = 0; i < BIG_VALUE; i++)
+    playlist3.push_back(tracks[i % tracks.size()], {0, i});
+  auto playlist4 = playlist3;
+  playlist4.pop_front();
+  assert(playlist3.size() == BIG_VALUE);
+  assert(playlist4.size() == BIG_VALUE - 1);
+  assert(playlist3.front().first == tracks[0]);
+  assert(playlist4.front().first == tracks[1]);
+
+  // Plejlistę można zbudować z zakresu par (utwór, parametry) i dopisywać
+  // do niej całe zakresy – albo wszystkie pary, albo żadną.
+  vector<pair<string_view, params_t>> block = {{tracks[2], params[5]},
+                                               {tracks[0], params[6]},
+                                               {tracks[2], params[4]}};
+  radio_t playlist5(block.begin(), block.end());
+  playlist5.append_range(block.begin(), block.begin() + 2);
+  assert(playlist5.size() == 5);
+  assert(playlist5.pay(playlist5.sorted_begin()).second == 3);
+  assert(playlist5.front().second == params[5]);
+
+  // Nieudana modyfikacja nie unieważnia iteratorów, również gdy mapa utworów
+  // jest współdzielona z kopią plejlisty.
+  playlist<int, fragile_t> playlist6;
+  playlist6.push_back(1, false);
+  playlist6.push_back(2, false);
+  auto playlist7 = playlist6;
+  playlist6.push_back(1, false);
+  auto sit = playlist6.sorted_begin();
+  try {
+    playlist6.push_back(3, true);
+    assert(false);
+  }
+  catch (std::runtime_error const &) {}
+  vector<pair<int, fragile_t>> block2;
+  block2.reserve(3);
+  block2.emplace_back(4, false);
+  block2.emplace_back(0, false);
+  block2.emplace_back(5, true);
+  try {
+    playlist6.append_range(block2.begin(), block2.end());
+    assert(false);
+  }
+  catch (std::runtime_error const &) {}
+  assert(playlist6.size() == 3 && playlist7.size() == 2);
+  assert(playlist6.pay(sit).first == 1);
+  assert(++sit != playlist6.sorted_end());
+  assert(++sit == playlist6.sorted_end());
 }